@@ -0,0 +1,190 @@
+#pragma once
+
+#include <iostream>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "ThreadPool.hpp"
+#include "RouteWorkspace.hpp"
+#include "Dijkstra.hpp"
+
+namespace Dijkstra
+{
+	struct Query
+	{
+		int origin;
+		int dst;
+		Router router;
+		bool isWeighted;
+	};
+
+	struct QueryResult
+	{
+		int cost;  //INT_MAX if dst can't be reached
+		int routeBegin;  //the route is stations[routeBegin] ... stations[routeBegin + routeLen - 1]
+		int routeLen;  //0 if dst can't be reached
+	};
+
+	//answers batches of queries on a work stealing pool, every worker keeps its own workspace between batches
+	//routers needing preprocessing get it built once per metric and reused by later batches until the graph changes
+	class BatchRouter
+	{
+	public:
+		//threadCnt 0 uses every hardware thread
+		explicit BatchRouter(int threadCnt = 0) : pool(threadCnt)
+		{
+			for (int w = 0; w < this->pool.size(); w++) this->workspaces.push_back(new RouteWorkspace());
+		}
+
+		~BatchRouter()
+		{
+			for (auto ws : this->workspaces) delete ws;
+			clear();
+		}
+
+		BatchRouter(BatchRouter&&) = delete;
+		BatchRouter(const BatchRouter&) = delete;
+		BatchRouter& operator =(const BatchRouter&) = delete;
+
+		inline int threadCnt() const {
+			return this->pool.size();
+		}
+
+		//results[k] answers queries[k], routes are packed into stations in query order
+		//queries with an idx out of range come back unreachable, returns false only if the graph is empty
+		bool run(const ds::CSRGraph& graph, const Query* queries, const int queryCnt, ds::Vector<QueryResult>& results, ds::Vector<int>& stations)
+		{
+			results.resize(0);
+			stations.resize(0);
+			if (graph.size() <= 0 || queryCnt < 0) return false; //size check
+			prepare(graph, queries, queryCnt);
+
+			ds::Vector<int*> routes;
+			routes.resize(queryCnt, nullptr);
+			results.resize(queryCnt);
+			this->pool.parallelFor(queryCnt, [&](const int k, const int worker) {
+				const Query& query = queries[k];
+				int routeLen = route(graph, query, routes[k], *this->workspaces[worker]);
+				if (routeLen <= 0)
+				{
+					free(routes[k]);
+					routes[k] = nullptr;
+					routeLen = 0;
+				}
+				results[k] = { routeLen > 0 ? costOf(graph, query.isWeighted, routes[k], routeLen) : INT_MAX, 0, routeLen };
+			});
+
+			int total = 0;
+			for (int k = 0; k < queryCnt; k++)
+			{
+				results[k].routeBegin = total;
+				total += results[k].routeLen;
+			}
+			stations.resize(total);
+			for (int k = 0; k < queryCnt; k++)
+			{
+				if (routes[k] == nullptr) continue;
+				memcpy(&stations[results[k].routeBegin], routes[k], results[k].routeLen * sizeof(int));
+				free(routes[k]);
+			}
+			return true;
+		}
+
+		//drops every preprocessed structure, the next batch rebuilds what it needs
+		void clear()
+		{
+			for (int w = 0; w < 2; w++)
+			{
+				this->hierarchies[w].clear();
+				this->customizableHierarchies[w].clear();
+				this->landmarks[w].clear();
+				this->routeTables[w].clear();
+				this->isTableRejected[w] = false;
+			}
+			this->fingerprint = 0;
+		}
+
+	private:
+		//builds what the routers of the batch need for graph, preprocessing of an older graph is dropped first
+		void prepare(const ds::CSRGraph& graph, const Query* queries, const int queryCnt)
+		{
+			const uint64_t current = RouteTable::fingerprintOf(graph, true);
+			if (current != this->fingerprint) clear();
+			this->fingerprint = current;
+			for (int k = 0; k < queryCnt; k++)
+			{
+				const int w = queries[k].isWeighted;
+				switch (queries[k].router)
+				{
+				case Router::ContractionHierarchy:
+					if (!this->hierarchies[w].isBuilt()) this->hierarchies[w].build(graph, w);
+					break;
+				case Router::CustomizableHierarchy:
+					if (!this->customizableHierarchies[w].isCustomized() && this->customizableHierarchies[w].build(graph))
+						this->customizableHierarchies[w].customize(graph, w);
+					break;
+				case Router::ALT:
+					if (!this->landmarks[w].isBuilt()) this->landmarks[w].build(graph, w);
+					break;
+				case Router::RouteTable:
+					if (!this->routeTables[w].isBuilt() && !this->isTableRejected[w])
+						this->isTableRejected[w] = !this->routeTables[w].build(graph, w);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		//same contract as Helper::findRoute, but preprocessed routers query the shared structures read only
+		//a router whose preprocessing failed falls back to plain Dijkstra
+		int route(const ds::CSRGraph& graph, const Query& query, int*& route, RouteWorkspace& ws) const
+		{
+			const int size = graph.size();
+			if (query.origin < 0 || query.origin >= size || query.dst < 0 || query.dst >= size) return 0; //idx check
+			const int w = query.isWeighted;
+			switch (query.router)
+			{
+			case Router::ContractionHierarchy:
+				if (this->hierarchies[w].isBuilt()) return this->hierarchies[w].calculate(query.origin, query.dst, route, ws);
+				break;
+			case Router::CustomizableHierarchy:
+				if (this->customizableHierarchies[w].isCustomized()) return this->customizableHierarchies[w].calculate(query.origin, query.dst, route, ws);
+				break;
+			case Router::ALT:
+				return Helper::calculateALT(graph, query.isWeighted, this->landmarks[w], query.origin, query.dst, route, ws);
+			case Router::RouteTable:
+				if (this->routeTables[w].isBuilt()) return this->routeTables[w].calculate(query.origin, query.dst, route);
+				break;
+			default:
+				return Helper::findRoute(query.router, graph, query.isWeighted, query.origin, query.dst, route, ws);
+			}
+			return Helper::calculate(graph, query.isWeighted, query.origin, query.dst, route, ws);
+		}
+
+		//cost of the route taking the cheapest arc between consecutive stations
+		static int costOf(const ds::CSRGraph& graph, const bool isWeighted, const int* route, const int routeLen)
+		{
+			if (!isWeighted) return routeLen - 1;
+			int cost = 0;
+			for (int k = 0; k + 1 < routeLen; k++)
+			{
+				int best = INT_MAX;
+				for (int e = graph.begin(route[k]); e < graph.end(route[k]); e++)
+					if (graph.targets[e] == route[k + 1] && graph.costs[e] > 0 && graph.costs[e] < best) best = graph.costs[e];
+				if (best == INT_MAX) return INT_MAX;
+				cost += best;
+			}
+			return cost;
+		}
+
+	private:
+		ds::ThreadPool pool;
+		ds::Vector<RouteWorkspace*> workspaces;  //one per pool worker
+		uint64_t fingerprint{ 0 };  //graph the preprocessing below was built from
+		ContractionHierarchy hierarchies[2];  //indexed by isWeighted
+		CustomizableHierarchy customizableHierarchies[2];
+		Landmarks landmarks[2];
+		RouteTable routeTables[2];
+		bool isTableRejected[2]{ false, false };  //network or costs don't fit a table, don't try again
+	};
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <iostream>
+#include <cassert>
+
+namespace ds
+{
+    //monotone priority queue over small integer keys (Dial's algorithm)
+    //keys must never be smaller than the last popped key nor larger than it plus maxStep,
+    //which holds for Dijkstra with arc costs in [0, maxStep], and then insert and pop are O(1) amortized
+    class BucketQueue {
+    public:
+        struct Entry
+        {
+            int idx;
+            int cost;
+        };
+
+        BucketQueue() = default;
+        ~BucketQueue() { destroy(); };
+
+        BucketQueue(BucketQueue&&) = delete;
+        BucketQueue(const BucketQueue&) = delete;
+        BucketQueue& operator=(const BucketQueue&) = delete;
+
+        //empties the queue and prepares one bucket per key in [curKey, curKey + maxStep], keeps memory around
+        bool reset(const int maxStep)
+        {
+            const int bucketCnt = maxStep + 1;
+            if (bucketCnt > this->bucketCapacity) {
+                int* p = (int*)realloc(this->head, bucketCnt * sizeof(int));
+                if (p == nullptr) return false;
+                this->head = p;
+                this->bucketCapacity = bucketCnt;
+            }
+            this->bucketCnt = bucketCnt;
+            memset(this->head, -1, bucketCnt * sizeof(int));
+            this->poolSize = 0;
+            this->freeList = -1;
+            this->size = 0;
+            this->curKey = 0;
+            return true;
+        }
+
+        //same signature as IndexedMinHeap::insert, but an idx inserted twice is queued twice and the caller skips the stale entry
+        //returns false if the entry pool couldn't grow, the entry is then lost and the search relying on it must give up
+        bool insert(const int idx, const int cost)
+        {
+            assert(cost >= this->curKey && cost < this->curKey + this->bucketCnt);
+            int slot = this->freeList;
+            if (slot != -1) this->freeList = this->next[slot];
+            else {
+                if (this->poolSize == this->poolCapacity && !grow()) return false;
+                slot = this->poolSize++;
+            }
+            const int bucket = cost % this->bucketCnt;
+            this->elem[slot] = { idx, cost };
+            this->next[slot] = this->head[bucket];
+            this->head[bucket] = slot;
+            this->size++;
+            return true;
+        }
+
+        void pop()
+        {
+            if (empty()) return;
+            const int bucket = advance();
+            const int slot = this->head[bucket];
+            this->head[bucket] = this->next[slot];
+            this->next[slot] = this->freeList;
+            this->freeList = slot;
+            this->size--;
+        }
+
+        bool empty() const
+        {
+            return this->size == 0;
+        }
+
+        Entry front()
+        {
+            return this->elem[this->head[advance()]];
+        }
+
+        void destroy() {
+            free(this->head);
+            free(this->elem);
+            free(this->next);
+            this->head = this->next = nullptr;
+            this->elem = nullptr;
+            this->bucketCapacity = this->bucketCnt = 0;
+            this->poolCapacity = this->poolSize = 0;
+            this->size = 0;
+        }
+
+    private:
+        //moves curKey up to the smallest key in the queue and returns its bucket, queue must not be empty
+        inline int advance()
+        {
+            while (this->head[this->curKey % this->bucketCnt] == -1) this->curKey++;
+            return this->curKey % this->bucketCnt;
+        }
+
+        bool grow()
+        {
+            const int newCapacity = this->poolCapacity ? this->poolCapacity * 2 : 64;
+            Entry* newElem = (Entry*)realloc(this->elem, newCapacity * sizeof(Entry));
+            if (newElem != nullptr) this->elem = newElem;
+            int* newNext = (int*)realloc(this->next, newCapacity * sizeof(int));
+            if (newNext != nullptr) this->next = newNext;
+            if (newElem == nullptr || newNext == nullptr) return false;
+            this->poolCapacity = newCapacity;
+            return true;
+        }
+
+    private:
+        int* head{ nullptr };  //first entry of every bucket, -1 if empty
+        int bucketCnt{ 0 };
+        int bucketCapacity{ 0 };
+        Entry* elem{ nullptr };  //entry pool, buckets are singly linked lists through next
+        int* next{ nullptr };
+        int poolSize{ 0 };
+        int poolCapacity{ 0 };
+        int freeList{ -1 };  //popped entries are recycled
+        int size{ 0 };
+        int curKey{ 0 };
+    };
+}
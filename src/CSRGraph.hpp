@@ -0,0 +1,88 @@
+#pragma once
+
+#include <math.h>
+#include <cstdint>
+#include "Vector.hpp"
+#include "LineSet.hpp"
+
+namespace ds
+{
+	//compact adjacency snapshot of a SubwayGraph, arcs are stored in both directions
+	//arcs leaving vertex i are targets[offsets[i]] ... targets[offsets[i + 1] - 1]
+	struct CSRGraph
+	{
+		int size() const {
+			return this->vexCnt;
+		}
+
+		int arcCnt() const {
+			return this->targets.size();
+		}
+
+		int begin(const int idx) const {
+			return this->offsets[idx];
+		}
+
+		int end(const int idx) const {
+			return this->offsets[idx + 1];
+		}
+
+		//number of (station, line) states, one per line served at each station
+		int stateCnt() const {
+			return this->stateOffsets[this->vexCnt];
+		}
+
+		//state of riding line at vertex idx, or -1 if the line doesn't serve idx
+		int stateOf(const int idx, const int line) const {
+			const uint64_t bit = 1ull << line;
+			if ((this->vexLineMasks[idx] & bit) == 0) return -1;
+			return this->stateOffsets[idx] + popcount(this->vexLineMasks[idx] & (bit - 1));
+		}
+
+		//largest arc cost of the metric, 1 when every arc counts as one stop
+		int maxArcCost(const bool isWeighted) const {
+			return isWeighted ? this->maxCost : 1;
+		}
+
+		//admissible lower bound of the cost from idx to dst, derived from station coordinates and the fastest arc
+		double lowerBound(const int idx, const int dst, const bool isWeighted) const {
+			const double speed = isWeighted ? this->maxSpeed : this->maxArcLength;
+			if (speed <= 0) return 0;
+			const double dx = this->coordX[idx] - this->coordX[dst];
+			const double dy = this->coordY[idx] - this->coordY[dst];
+			return sqrt(dx * dx + dy * dy) / speed * (1 - 1e-9);  //shrink a hair so rounding never overestimates
+		}
+
+		void clear() {
+			this->vexCnt = 0;
+			this->offsets.clear();
+			this->targets.clear();
+			this->costs.clear();
+			this->lineMasks.clear();
+			this->vexLineMasks.clear();
+			this->stateOffsets.clear();
+			this->stateVexes.clear();
+			this->stateLines.clear();
+			this->coordX.clear();
+			this->coordY.clear();
+			this->maxSpeed = 0;
+			this->maxArcLength = 0;
+			this->maxCost = 0;
+		}
+
+		int vexCnt{ 0 };
+		ds::Vector<int> offsets;
+		ds::Vector<int> targets;
+		ds::Vector<int> costs;
+		ds::Vector<uint64_t> lineMasks;  //lines running on each arc
+		ds::Vector<uint64_t> vexLineMasks;  //lines running on any arc of each vertex
+		ds::Vector<int> stateOffsets;  //first (station, line) state of each vertex, see stateOf()
+		ds::Vector<int> stateVexes;  //vertex of each state
+		ds::Vector<int> stateLines;  //line of each state
+		ds::Vector<double> coordX;
+		ds::Vector<double> coordY;
+		double maxSpeed{ 0 };  //max coordinate distance per unit of arc cost
+		double maxArcLength{ 0 };  //max coordinate distance of a single arc
+		int maxCost{ 0 };
+	};
+}
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <iostream>
+#include "Vector.hpp"
+#include "MinHeap.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+
+namespace Dijkstra
+{
+	constexpr int CH_WITNESS_SETTLE_LIMIT = 128;  //witness searches give up after settling this many vertexes, a missed witness only costs an extra shortcut
+
+	//vertexes ranked by importance, every arc stored once on its lower ranked end pointing upwards
+	//the graph is symmetric so the downward graph is the upward one read backwards
+	//a query is two upward searches, one from each end, that meet at the highest vertex of the route
+	//shared by ContractionHierarchy and CustomizableHierarchy, which differ in how the arcs and their costs are found
+	class UpwardHierarchy
+	{
+	public:
+		UpwardHierarchy(UpwardHierarchy&&) = delete;
+		UpwardHierarchy(const UpwardHierarchy&) = delete;
+		UpwardHierarchy& operator =(const UpwardHierarchy&) = delete;
+
+		inline bool isBuilt() const {
+			return this->vexCnt > 0;
+		}
+
+		inline int size() const {
+			return this->vexCnt;
+		}
+
+		//position of idx in the order, higher ranked vertexes are the more important ones
+		inline int rankOf(const int idx) const {
+			return this->rank[idx];
+		}
+
+		//cost of the cheapest route, INT_MAX if dst can't be reached
+		int distance(const int origin, const int dst, RouteWorkspace& ws) const
+		{
+			int best = INT_MAX;
+			search(origin, dst, ws, best);
+			return best;
+		}
+
+		//same contract as Helper::calculate, shortcuts are unpacked so route holds every station passed
+		int calculate(const int origin, const int dst, int*& route, RouteWorkspace& ws) const
+		{
+			int best = INT_MAX;
+			const int meet = search(origin, dst, ws, best);
+			if (meet == -1) return 0; //unreachable
+			RouteWorkspace& bws = ws.backward();
+
+			int routeLen = 1;
+			for (int v = meet; ws.parentOf(v) != -1; v = ws.parentOf(v)) routeLen += this->upHops[ws.secondaryOf(v)];
+			for (int v = meet; bws.parentOf(v) != -1; v = bws.parentOf(v)) routeLen += this->upHops[bws.secondaryOf(v)];
+			if (route == nullptr)
+				route = (int*)malloc(routeLen * sizeof(int));
+			if (route == nullptr) return 0;
+
+			ds::Vector<int> chain;  //forward search tree from meet down to origin, unpacked in reverse
+			for (int v = meet; ws.parentOf(v) != -1; v = ws.parentOf(v)) chain.push_back(v);
+			int i = 0;
+			route[i++] = origin;
+			for (int k = chain.size() - 1; k >= 0; k--) appendArc(ws.parentOf(chain[k]), ws.secondaryOf(chain[k]), route, i);
+			for (int v = meet; bws.parentOf(v) != -1; v = bws.parentOf(v)) appendArc(v, bws.secondaryOf(v), route, i);  //backward parents point towards dst
+			return routeLen;
+		}
+
+		//costs from every source to every target into result[s * targetCnt + t], INT_MAX where unreachable
+		//one upward search per target leaves (target, cost) buckets on the vertexes it settles,
+		//then one upward search per source scans the buckets it meets, so no search is repeated per pair
+		bool manyToMany(const int* sources, const int sourceCnt, const int* targets, const int targetCnt, int* result, RouteWorkspace& ws) const
+		{
+			if (!isBuilt() || sourceCnt < 0 || targetCnt < 0 || result == nullptr) return false;
+			for (int k = 0; k < sourceCnt * targetCnt; k++) result[k] = INT_MAX;
+			for (int k = 0; k < sourceCnt; k++) if (sources[k] < 0 || sources[k] >= this->vexCnt) return false; //idx check
+			for (int k = 0; k < targetCnt; k++) if (targets[k] < 0 || targets[k] >= this->vexCnt) return false;
+
+			ds::Vector<Bucket> entries;  //every (vertex, target, cost) left by a backward search, then sorted by vertex
+			for (int t = 0; t < targetCnt; t++)
+				upwardSearch(targets[t], ws, [&](const int v, const int cost) { entries.push_back({ v, t, cost }); });
+			ds::Vector<int> bucketOffsets;
+			bucketOffsets.resize(this->vexCnt + 1, 0);
+			for (const auto& entry : entries) bucketOffsets[entry.vex + 1]++;
+			for (int v = 0; v < this->vexCnt; v++) bucketOffsets[v + 1] += bucketOffsets[v];
+			ds::Vector<Bucket> buckets;
+			buckets.resize(entries.size());
+			for (const auto& entry : entries) buckets[bucketOffsets[entry.vex]++] = entry;
+			for (int v = this->vexCnt; v > 0; v--) bucketOffsets[v] = bucketOffsets[v - 1];  //the fill moved every offset one slot forward
+			bucketOffsets[0] = 0;
+
+			for (int s = 0; s < sourceCnt; s++)
+			{
+				int* row = result + s * targetCnt;
+				upwardSearch(sources[s], ws, [&](const int v, const int cost) {
+					for (int k = bucketOffsets[v]; k < bucketOffsets[v + 1]; k++)
+						if (cost + buckets[k].cost < row[buckets[k].target]) row[buckets[k].target] = cost + buckets[k].cost;
+				});
+			}
+			return true;
+		}
+
+	protected:
+		UpwardHierarchy() = default;
+		~UpwardHierarchy() { clearArcs(); };
+
+		void clearArcs()
+		{
+			this->vexCnt = 0;
+			this->rank.clear();
+			this->upOffsets.clear();
+			this->upSources.clear();
+			this->upTargets.clear();
+			this->upCosts.clear();
+			this->upChildA.clear();
+			this->upChildB.clear();
+			this->upHops.clear();
+		}
+
+		//two upward searches with stall on demand, returns the meeting vertex of the cheapest route or -1
+		int search(const int origin, const int dst, RouteWorkspace& ws, int& best) const
+		{
+			best = INT_MAX;
+			if (!isBuilt()) return -1;
+			if (origin < 0 || origin >= this->vexCnt || dst < 0 || dst >= this->vexCnt) return -1; //idx check
+			RouteWorkspace& bws = ws.backward();
+			ds::IndexedMinHeap<int>& fwdHeap = ws.costHeap();
+			ds::IndexedMinHeap<int>& bwdHeap = bws.costHeap();
+			if (!ws.reset(this->vexCnt) || !bws.reset(this->vexCnt)) return -1;
+			if (!fwdHeap.reset(this->vexCnt) || !bwdHeap.reset(this->vexCnt)) return -1;
+			ws.relax(origin, 0, -1, -1);
+			bws.relax(dst, 0, -1, -1);
+			fwdHeap.insert(origin, 0);
+			bwdHeap.insert(dst, 0);
+
+			int meet = -1;
+			while (true) {
+				const bool fwdOpen = !fwdHeap.empty() && fwdHeap.front().cost < best;  //a side stops once it can't beat best
+				const bool bwdOpen = !bwdHeap.empty() && bwdHeap.front().cost < best;
+				if (!fwdOpen && !bwdOpen) break;
+				const bool isForward = fwdOpen && (!bwdOpen || fwdHeap.front().cost <= bwdHeap.front().cost);
+				auto& heap = isForward ? fwdHeap : bwdHeap;
+				RouteWorkspace& cur = isForward ? ws : bws;
+				const RouteWorkspace& other = isForward ? bws : ws;
+				const auto curNode = heap.front();
+				heap.pop();
+				cur.settle(curNode.idx);
+				if (other.isReached(curNode.idx) && curNode.cost + other.dis(curNode.idx) < best)
+				{
+					best = curNode.cost + other.dis(curNode.idx);
+					meet = curNode.idx;
+				}
+
+				const int first = this->upOffsets[this->rank[curNode.idx]];
+				const int last = this->upOffsets[this->rank[curNode.idx] + 1];
+				bool isStalled = false;  //a higher vertex already reaches this one cheaper, so nothing found from here can be optimal
+				for (int e = first; e < last && !isStalled; e++)
+					isStalled = this->upCosts[e] != INT_MAX && cur.isReached(this->upTargets[e]) && cur.dis(this->upTargets[e]) + this->upCosts[e] < curNode.cost;
+				if (isStalled) continue;
+				for (int e = first; e < last; e++)
+				{
+					if (this->upCosts[e] == INT_MAX) continue;  //not connected under the current metric
+					const int i = this->upTargets[e];
+					const int dis = curNode.cost + this->upCosts[e];
+					if (dis < cur.dis(i))
+					{
+						cur.relax(i, dis, e, curNode.idx);  //secondary keeps the arc, so shortcuts can be unpacked later
+						heap.insert(i, dis);
+					}
+				}
+			}
+			return meet;
+		}
+
+		//plain upward search from origin with stall on demand, visit(vertex, cost) is called for every vertex settled unstalled
+		template<class Visit>
+		void upwardSearch(const int origin, RouteWorkspace& ws, Visit visit) const
+		{
+			ds::IndexedMinHeap<int>& minHeap = ws.costHeap();
+			if (!ws.reset(this->vexCnt) || !minHeap.reset(this->vexCnt)) return;
+			ws.relax(origin, 0, -1);
+			minHeap.insert(origin, 0);
+			while (!minHeap.empty()) {
+				const auto curNode = minHeap.front();
+				minHeap.pop();
+				ws.settle(curNode.idx);
+				const int first = this->upOffsets[this->rank[curNode.idx]];
+				const int last = this->upOffsets[this->rank[curNode.idx] + 1];
+				bool isStalled = false;
+				for (int e = first; e < last && !isStalled; e++)
+					isStalled = this->upCosts[e] != INT_MAX && ws.isReached(this->upTargets[e]) && ws.dis(this->upTargets[e]) + this->upCosts[e] < curNode.cost;
+				if (isStalled) continue;
+				visit(curNode.idx, curNode.cost);
+				for (int e = first; e < last; e++)
+				{
+					if (this->upCosts[e] == INT_MAX) continue;  //not connected under the current metric
+					const int dis = curNode.cost + this->upCosts[e];
+					if (dis < ws.dis(this->upTargets[e]))
+					{
+						ws.relax(this->upTargets[e], dis, curNode.idx);
+						minHeap.insert(this->upTargets[e], dis);
+					}
+				}
+			}
+		}
+
+		//writes the stations of upward arc e walked from its end from, excluding from itself
+		void appendArc(const int from, const int e, int* route, int& i) const
+		{
+			const int to = this->upSources[e] == from ? this->upTargets[e] : this->upSources[e];
+			if (this->upChildA[e] == -1)
+			{
+				route[i++] = to;
+				return;
+			}
+			//both children leave the middle vertex, walk the one reaching from backwards, then the other forwards
+			const int first = this->upTargets[this->upChildA[e]] == from ? this->upChildA[e] : this->upChildB[e];
+			const int second = first == this->upChildA[e] ? this->upChildB[e] : this->upChildA[e];
+			appendArc(from, first, route, i);
+			appendArc(this->upSources[second], second, route, i);
+		}
+
+	protected:
+		struct Bucket
+		{
+			int vex;
+			int target;
+			int cost;
+		};
+
+		int vexCnt{ 0 };
+		ds::Vector<int> rank;  //position of every vertex in the order
+		ds::Vector<int> upOffsets;  //upward arcs of the vertex ranked k are upOffsets[k] ... upOffsets[k + 1] - 1
+		ds::Vector<int> upSources;
+		ds::Vector<int> upTargets;
+		ds::Vector<int> upCosts;  //INT_MAX if the arc isn't usable
+		ds::Vector<int> upChildA;  //for shortcuts, the two upward arcs leaving the middle vertex, -1 for original arcs
+		ds::Vector<int> upChildB;
+		ds::Vector<int> upHops;  //original arcs an arc stands for
+	};
+
+	//contraction hierarchy over a CSRGraph snapshot, built once per metric and then queried many times
+	//vertexes are contracted in order of importance, adding a shortcut wherever a contracted vertex was the only cheapest way between two neighbours
+	class ContractionHierarchy : public UpwardHierarchy
+	{
+	public:
+		ContractionHierarchy() = default;
+		~ContractionHierarchy() { clear(); };
+
+		//preprocessing, O(V) witness searches of bounded size, returns false if the graph is empty or memory runs out
+		bool build(const ds::CSRGraph& graph, const bool isWeighted)
+		{
+			clear();
+			const int size = graph.size();
+			if (size <= 0) return false; //size check
+
+			ds::Vector<ds::Vector<BuildArc>> adj;  //remaining graph, contracted vertexes are unlinked from it
+			adj.resize(size);
+			for (int i = 0; i < size; i++)
+			{
+				for (int e = graph.begin(i); e < graph.end(i); e++)
+				{
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0 || graph.targets[e] == i) continue;  //not connected
+					link(adj[i], { graph.targets[e], cost, -1, -1 });
+				}
+			}
+
+			ds::Vector<int> deleted;  //contracted neighbours of every vertex
+			ds::Vector<int> level;  //depth of every vertex in the hierarchy
+			deleted.resize(size, 0);
+			level.resize(size, 0);
+			this->rank.resize(size);
+			this->upOffsets.resize(size + 1);
+			this->upOffsets[0] = 0;
+
+			RouteWorkspace ws;
+			ds::IndexedMinHeap<int> order;
+			if (!order.reset(size))
+			{
+				adj.clear_destruct();
+				return false;
+			}
+			for (int i = 0; i < size; i++) order.insert(i, priorityOf(adj, ws, i, deleted[i], level[i]));
+
+			int contracted = 0;
+			while (!order.empty()) {
+				const int v = order.front().idx;
+				order.pop();
+				const int priority = priorityOf(adj, ws, v, deleted[v], level[v]);
+				if (!order.empty() && priority > order.front().cost)  //lazy update, v got less attractive since it was queued
+				{
+					order.insert(v, priority);
+					continue;
+				}
+
+				this->rank[v] = contracted++;
+				contract(adj, ws, v, false);
+				for (const auto& arc : adj[v])
+				{
+					adj[arc.target].find_erase({ v, 0, -1, -1 });  //unlink v, arcs are compared by target only
+					deleted[arc.target]++;
+					if (level[arc.target] < level[v] + 1) level[arc.target] = level[v] + 1;
+				}
+				this->upOffsets[contracted] = this->upTargets.size();
+			}
+
+			adj.clear_destruct();
+			this->vexCnt = size;
+			this->weighted = isWeighted;
+			return true;
+		}
+
+		inline bool isWeighted() const {
+			return this->weighted;
+		}
+
+		inline int shortcutCnt() const {
+			return this->shortcuts;
+		}
+
+		void clear()
+		{
+			clearArcs();
+			this->shortcuts = 0;
+		}
+
+	private:
+		struct BuildArc
+		{
+			int target;
+			int cost;
+			int childA;  //for shortcuts, the two upward arcs leaving the contracted middle vertex, -1 for original arcs
+			int childB;
+
+			bool operator == (const BuildArc& arc) const {
+				return this->target == arc.target;
+			}
+		};
+
+		//adds arc to list, or lowers the cost of the arc already there
+		static void link(ds::Vector<BuildArc>& list, const BuildArc& arc)
+		{
+			BuildArc* it = list.find(arc);
+			if (it == list.end()) list.push_back(arc);
+			else if (arc.cost < it->cost) *it = arc;
+		}
+
+		//bounded Dijkstra from origin in the remaining graph that never passes through skipped, distances are left in ws
+		static void witnessSearch(const ds::Vector<ds::Vector<BuildArc>>& adj, RouteWorkspace& ws, const int origin, const int skipped, const int limit)
+		{
+			ds::IndexedMinHeap<int>& minHeap = ws.costHeap();
+			if (!ws.reset(adj.size()) || !minHeap.reset(adj.size())) return;
+			ws.settle(skipped);
+			ws.relax(origin, 0, -1);
+			minHeap.insert(origin, 0);
+			for (int settled = 0; !minHeap.empty() && settled < CH_WITNESS_SETTLE_LIMIT; settled++) {
+				const auto curNode = minHeap.front();
+				if (curNode.cost > limit) break;
+				minHeap.pop();
+				ws.settle(curNode.idx);
+				for (const auto& arc : adj[curNode.idx])
+				{
+					if (ws.isSettled(arc.target)) continue;
+					const int dis = curNode.cost + arc.cost;
+					if (dis < ws.dis(arc.target))
+					{
+						ws.relax(arc.target, dis, curNode.idx);
+						minHeap.insert(arc.target, dis);
+					}
+				}
+			}
+		}
+
+		//contracts v, or only counts the shortcuts it would need when simulate is set
+		int contract(ds::Vector<ds::Vector<BuildArc>>& adj, RouteWorkspace& ws, const int v, const bool simulate)
+		{
+			const int base = this->upTargets.size();  //upward arcs of v are about to take these slots
+			const int degree = adj[v].size();
+			if (!simulate)
+			{
+				for (const auto& arc : adj[v])
+				{
+					this->upSources.push_back(v);
+					this->upTargets.push_back(arc.target);
+					this->upCosts.push_back(arc.cost);
+					this->upChildA.push_back(arc.childA);
+					this->upChildB.push_back(arc.childB);
+					this->upHops.push_back(arc.childA == -1 ? 1 : this->upHops[arc.childA] + this->upHops[arc.childB]);
+				}
+			}
+
+			int added = 0;
+			for (int a = 0; a + 1 < degree; a++)
+			{
+				const BuildArc in = adj[v][a];
+				int maxOut = 0;
+				for (int b = a + 1; b < degree; b++)
+					if (adj[v][b].cost > maxOut) maxOut = adj[v][b].cost;
+				witnessSearch(adj, ws, in.target, v, in.cost + maxOut);
+				for (int b = a + 1; b < degree; b++)
+				{
+					const BuildArc out = adj[v][b];
+					const int via = in.cost + out.cost;
+					if (ws.dis(out.target) <= via) continue;  //a witness route avoids v
+					added++;
+					if (simulate) continue;
+					link(adj[in.target], { out.target, via, base + a, base + b });
+					link(adj[out.target], { in.target, via, base + a, base + b });
+					this->shortcuts++;
+				}
+			}
+			return added;
+		}
+
+		//edge difference plus contracted neighbours and depth, lower is contracted first
+		int priorityOf(ds::Vector<ds::Vector<BuildArc>>& adj, RouteWorkspace& ws, const int v, const int deleted, const int level)
+		{
+			return 2 * (contract(adj, ws, v, true) - adj[v].size()) + deleted + level;
+		}
+
+	private:
+		bool weighted{ false };
+		int shortcuts{ 0 };
+	};
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <iostream>
+#include "Vector.hpp"
+#include "MinHeap.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "ContractionHierarchy.hpp"
+
+namespace Dijkstra
+{
+	//contraction hierarchy split into a metric independent build and a cheap customization
+	//build() only looks at which stations are connected: vertexes are eliminated in minimum degree order and every fill arc is kept,
+	//so whatever the costs are, the lower triangles of an arc are all the ways a lower vertex can shortcut it
+	//customize() then derives every arc cost from its lower triangles, arcs only depend on arcs stored before them
+	//after a batch of cost changes only the arcs depending on a changed one are recomputed, the topology stays untouched
+	class CustomizableHierarchy : public UpwardHierarchy
+	{
+	public:
+		CustomizableHierarchy() = default;
+		~CustomizableHierarchy() { clear(); };
+
+		//metric independent preprocessing, arcs are kept whatever their cost so later cost changes never need a rebuild
+		bool build(const ds::CSRGraph& graph)
+		{
+			clear();
+			const int size = graph.size();
+			if (size <= 0) return false; //size check
+
+			ds::Vector<ds::Vector<int>> adj;  //remaining graph, eliminated vertexes are unlinked from it
+			adj.resize(size);
+			for (int i = 0; i < size; i++)
+				for (int e = graph.begin(i); e < graph.end(i); e++)
+					if (graph.targets[e] != i && !adj[i].contains(graph.targets[e])) adj[i].push_back(graph.targets[e]);
+
+			ds::IndexedMinHeap<int> order;
+			if (!order.reset(size))
+			{
+				adj.clear_destruct();
+				return false;
+			}
+			for (int i = 0; i < size; i++) order.insert(i, adj[i].size());
+			this->rank.resize(size);
+			this->upOffsets.resize(size + 1);
+			this->upOffsets[0] = 0;
+			int eliminated = 0;
+			while (!order.empty()) {
+				const int v = order.front().idx;
+				order.pop();
+				if (!order.empty() && adj[v].size() > order.front().cost)  //lazy update, fill arcs raised the degree of v
+				{
+					order.insert(v, adj[v].size());
+					continue;
+				}
+
+				this->rank[v] = eliminated++;
+				for (int a = 0; a < adj[v].size(); a++)
+				{
+					this->upSources.push_back(v);
+					this->upTargets.push_back(adj[v][a]);
+					for (int b = a + 1; b < adj[v].size(); b++)  //the remaining neighbours of v become a clique
+					{
+						if (adj[adj[v][a]].contains(adj[v][b])) continue;
+						adj[adj[v][a]].push_back(adj[v][b]);
+						adj[adj[v][b]].push_back(adj[v][a]);
+					}
+				}
+				for (const int neighbour : adj[v])
+				{
+					adj[neighbour].find_erase(v);
+					order.insert(neighbour, adj[neighbour].size());  //only lowers the key, raises are caught lazily above
+				}
+				this->upOffsets[eliminated] = this->upTargets.size();
+			}
+			adj.clear_destruct();
+			this->vexCnt = size;
+
+			//every pair of upward arcs of a vertex is a lower triangle of the arc between their targets
+			const int arcCnt = this->upTargets.size();
+			this->triOffsets.resize(arcCnt + 1, 0);
+			this->upperOffsets.resize(arcCnt + 1, 0);
+			for (int pass = 0; pass < 2; pass++)  //count, then fill
+			{
+				for (int k = 0; k < size; k++)
+				{
+					for (int a = this->upOffsets[k]; a < this->upOffsets[k + 1]; a++)
+					{
+						for (int b = a + 1; b < this->upOffsets[k + 1]; b++)
+						{
+							const int top = arcBetween(this->upTargets[a], this->upTargets[b]);
+							if (pass == 0)
+							{
+								this->triOffsets[top + 1]++;
+								this->upperOffsets[a + 1]++;
+								this->upperOffsets[b + 1]++;
+								continue;
+							}
+							this->triLow[this->triOffsets[top]] = a;
+							this->triHigh[this->triOffsets[top]++] = b;
+							this->upperArcs[this->upperOffsets[a]++] = top;
+							this->upperArcs[this->upperOffsets[b]++] = top;
+						}
+					}
+				}
+				if (pass == 0)
+				{
+					for (int a = 0; a < arcCnt; a++)
+					{
+						this->triOffsets[a + 1] += this->triOffsets[a];
+						this->upperOffsets[a + 1] += this->upperOffsets[a];
+					}
+					this->triLow.resize(this->triOffsets[arcCnt]);
+					this->triHigh.resize(this->triOffsets[arcCnt]);
+					this->upperArcs.resize(this->upperOffsets[arcCnt]);
+				}
+			}
+			for (int a = arcCnt; a > 0; a--)  //the fill pass moved every offset one slot forward
+			{
+				this->triOffsets[a] = this->triOffsets[a - 1];
+				this->upperOffsets[a] = this->upperOffsets[a - 1];
+			}
+			this->triOffsets[0] = this->upperOffsets[0] = 0;
+
+			this->upCosts.resize(arcCnt, INT_MAX);
+			this->upChildA.resize(arcCnt, -1);
+			this->upChildB.resize(arcCnt, -1);
+			this->upHops.resize(arcCnt, 1);
+			this->baseCosts.resize(arcCnt, INT_MAX);
+			return true;
+		}
+
+		//loads the costs of graph, which must have the topology build() saw, arcs may have been removed but not added
+		//the first call, or a change of metric, computes every arc, later calls only the arcs affected by changed costs
+		//returns the number of arcs recomputed, or -1 if the graph doesn't fit the hierarchy and build() has to run again
+		int customize(const ds::CSRGraph& graph, const bool isWeighted)
+		{
+			if (!isBuilt() || graph.size() != this->vexCnt) return -1;
+			const int arcCnt = this->upTargets.size();
+			ds::Vector<int> costs;  //cheapest original arc between the ends of every arc
+			costs.resize(arcCnt, INT_MAX);
+			for (int i = 0; i < this->vexCnt; i++)
+			{
+				for (int e = graph.begin(i); e < graph.end(i); e++)
+				{
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0 || graph.targets[e] == i) continue;  //not connected
+					const int a = arcBetween(i, graph.targets[e]);
+					if (a == -1) return -1; //arc unknown to the hierarchy
+					if (cost < costs[a]) costs[a] = cost;
+				}
+			}
+
+			int recomputed = 0;
+			if (!this->customized || this->weighted != isWeighted)
+			{
+				this->baseCosts.swap(costs);
+				for (int a = 0; a < arcCnt; a++) recompute(a);
+				recomputed = arcCnt;
+			}
+			else
+			{
+				ds::IndexedMinHeap<int> dirty;  //keyed by the arc itself, so arcs are redone after everything they depend on
+				if (!dirty.reset(arcCnt)) return -1;
+				for (int a = 0; a < arcCnt; a++)
+				{
+					if (costs[a] == this->baseCosts[a]) continue;
+					this->baseCosts[a] = costs[a];
+					dirty.insert(a, a);
+				}
+				while (!dirty.empty()) {
+					const int a = dirty.front().idx;
+					dirty.pop();
+					recomputed++;
+					if (!recompute(a)) continue;
+					for (int k = this->upperOffsets[a]; k < this->upperOffsets[a + 1]; k++) dirty.insert(this->upperArcs[k], this->upperArcs[k]);
+				}
+			}
+			this->customized = true;
+			this->weighted = isWeighted;
+			return recomputed;
+		}
+
+		inline bool isCustomized() const {
+			return this->customized;
+		}
+
+		inline bool isWeighted() const {
+			return this->weighted;
+		}
+
+		inline int arcCnt() const {
+			return this->upTargets.size();
+		}
+
+		void clear()
+		{
+			clearArcs();
+			this->customized = false;
+			this->weighted = false;
+			this->baseCosts.clear();
+			this->triOffsets.clear();
+			this->triLow.clear();
+			this->triHigh.clear();
+			this->upperOffsets.clear();
+			this->upperArcs.clear();
+		}
+
+	private:
+		//upward arc between x and y, -1 if there is none
+		int arcBetween(const int x, const int y) const
+		{
+			const int lower = this->rank[x] < this->rank[y] ? x : y;
+			const int upper = lower == x ? y : x;
+			for (int e = this->upOffsets[this->rank[lower]]; e < this->upOffsets[this->rank[lower] + 1]; e++)
+				if (this->upTargets[e] == upper) return e;
+			return -1;
+		}
+
+		//cheapest of the original arc and the lower triangles of a, returns whether its cost or unpacked length changed
+		bool recompute(const int a)
+		{
+			int cost = this->baseCosts[a];
+			int childA = -1;
+			int childB = -1;
+			int hops = 1;
+			for (int k = this->triOffsets[a]; k < this->triOffsets[a + 1]; k++)
+			{
+				const int low = this->triLow[k];
+				const int high = this->triHigh[k];
+				if (this->upCosts[low] == INT_MAX || this->upCosts[high] == INT_MAX) continue;
+				if (this->upCosts[low] + this->upCosts[high] < cost)
+				{
+					cost = this->upCosts[low] + this->upCosts[high];
+					childA = low;
+					childB = high;
+					hops = this->upHops[low] + this->upHops[high];
+				}
+			}
+			const bool isChanged = cost != this->upCosts[a] || hops != this->upHops[a];
+			this->upCosts[a] = cost;
+			this->upChildA[a] = childA;
+			this->upChildB[a] = childB;
+			this->upHops[a] = hops;
+			return isChanged;
+		}
+
+	private:
+		bool customized{ false };
+		bool weighted{ false };
+		ds::Vector<int> baseCosts;  //cheapest original arc, INT_MAX for fill arcs and removed arcs
+		ds::Vector<int> triOffsets;  //lower triangles of arc a are triLow/triHigh[triOffsets[a]] ... [triOffsets[a + 1] - 1]
+		ds::Vector<int> triLow;  //the two arcs from the bottom vertex of the triangle
+		ds::Vector<int> triHigh;
+		ds::Vector<int> upperOffsets;  //arcs having arc a in a lower triangle are upperArcs[upperOffsets[a]] ... [upperOffsets[a + 1] - 1]
+		ds::Vector<int> upperArcs;
+	};
+}
@@ -2,22 +2,28 @@
 
 #include <iostream>
 #include "MinHeap.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "Search.hpp"
+#include "TransferRouter.hpp"
+#include "ContractionHierarchy.hpp"
+#include "CustomizableHierarchy.hpp"
+#include "Landmarks.hpp"
+#include "HubLabels.hpp"
+#include "RouteTable.hpp"
 
 namespace Dijkstra
 {
-	struct HeapElemWrapper
+	enum class Router
 	{
-		HeapElemWrapper(int idx, int cost) : idx(idx), cost(cost) {};
-		int idx;
-		int cost;
-
-		bool operator < (const HeapElemWrapper& hew) const {
-			return this->cost < hew.cost;
-		}
-
-		bool operator > (const HeapElemWrapper& hew) const {
-			return this->cost > hew.cost;
-		}
+		Dijkstra,  //plain Dijkstra, stops once dst is settled
+		AStar,  //goal directed, see calculateAStar
+		Bidirectional,  //searches from both ends, see calculateBidirectional
+		TransferAware,  //(station, line) states, fewest transfers among the cheapest routes, see TransferRouter
+		ContractionHierarchy,  //upward searches over a preprocessed hierarchy, see ContractionHierarchy
+		CustomizableHierarchy,  //same queries, but cost changes only need a cheap customization, see CustomizableHierarchy
+		ALT,  //A* with landmark lower bounds, see calculateALT
+		RouteTable,  //lookups in a precomputed all pairs table, see RouteTable
 	};
 
 	class Helper
@@ -28,45 +34,48 @@ namespace Dijkstra
 		Helper(const Helper&) = delete;
 		Helper& operator =(const Helper&) = delete;
 
+		//walks the predecessor tree backwards from dst, route is allocated if it is nullptr
+		static int unwindRoute(const int* parent, const int dst, int*& route)
+		{
+			if (dst < 0) return 0; //unreachable
+			int routeLen = 0;
+			for (int v = dst; v != -1; v = parent[v]) routeLen++;
+			if (route == nullptr)
+				route = (int*)malloc(routeLen * sizeof(int));
+			if (route == nullptr) return 0;
+			int i = routeLen;
+			for (int v = dst; v != -1; v = parent[v]) route[--i] = v;
+			return routeLen;
+		}
+
 	public:
 		static int calculate(const int** mat, const size_t size, const int origin, const int dst, int*& route) //returns route length and route
 		{
 			if (size <= 0) return 0; //size check
 
-			ds::MinHeap<HeapElemWrapper> minHeap;
-			minHeap.insert(HeapElemWrapper(origin, 0));
-
-			bool* isVisited = (bool*)malloc((size + 1) * sizeof(bool));
-			if (isVisited != nullptr)
-				memset(isVisited, 0, (size + 1) * sizeof(bool));
-			else return 0;
-
-			int* minDis = (int*)malloc((size + 1) * sizeof(int));
-			if (minDis != nullptr)
-				for (uint32_t i = 0; i < size; i++) minDis[i] = INT_MAX;
-			else return 0;
+			bool* isVisited = (bool*)malloc(size * sizeof(bool));
+			int* minDis = (int*)malloc(size * sizeof(int));
+			int* parent = (int*)malloc(size * sizeof(int));
+			if (isVisited == nullptr || minDis == nullptr || parent == nullptr)
+			{
+				free(isVisited);
+				free(minDis);
+				free(parent);
+				return 0;
+			}
+			memset(isVisited, 0, size * sizeof(bool));
+			memset(parent, -1, size * sizeof(int));
+			for (uint32_t i = 0; i < size; i++) minDis[i] = INT_MAX;
 			minDis[origin] = 0;
 
-			int** routes = (int**)malloc((size + 1) * sizeof(int*));
-			if (routes != nullptr)
-				for (uint32_t i = 0; i <= size; i++)
-				{
-					routes[i] = (int*)malloc((size + 1) * sizeof(int));
-					if (routes[i] != nullptr)
-						memset(routes[i], -1, (size + 1) * sizeof(int));
-					else return 0;
-				}
-			else return 0;
-
-			int* routeLength = (int*)malloc((size + 1) * sizeof(int));
-			memset(routeLength, 0, (size + 1) * sizeof(int));
-			routeLength[origin] = 1;
-			routes[origin][0] = origin;
-
+			ds::IndexedMinHeap<int> minHeap;
+			minHeap.reset(size);
+			minHeap.insert(origin, 0);
 			while (!minHeap.empty()) {
 				auto curNode = minHeap.front(); 
 				minHeap.pop();
 				isVisited[curNode.idx] = true;
+				if (curNode.idx == dst) break; //point to point, dst is settled
 				for (uint32_t i = 0; i < size; i++)
 				{
 					if ((mat[curNode.idx][i] > 0) && !isVisited[i])  //is connected and not visited
@@ -75,29 +84,264 @@ namespace Dijkstra
 						if (dis < minDis[i])
 						{
 							minDis[i] = dis;
-							memcpy_s(routes[i], routeLength[curNode.idx] * sizeof(int), routes[curNode.idx], routeLength[curNode.idx] * sizeof(int)); //update route
-							routeLength[i] = routeLength[curNode.idx] + 1;
-							routes[i][routeLength[i] - 1] = i;
+							parent[i] = curNode.idx;  //only the predecessor is recorded, the route is unwound once at the end
+							minHeap.insert(i, dis);  //decrease key, the heap never holds more than size entries
 						}
-						minHeap.insert(HeapElemWrapper(i, minDis[i]));
 					}
 				}
 			}
 
-			int routeLen = routeLength[dst];
-
-			if (route == nullptr)
-				route = (int*)malloc(routeLen * sizeof(int));
-
-			memcpy_s(route, routeLen * sizeof(int), routes[dst], routeLen * sizeof(int));  //save route
+			int routeLen = unwindRoute(parent, minDis[dst] != INT_MAX ? dst : -1, route);  //save route
 			//some cleanup
-			for (uint32_t i = 0; i <= size; i++) free(routes[i]);
-			free(routes);
-			free(routeLength);
 			free(isVisited);
 			free(minDis);
+			free(parent);
 
 			return routeLen;
 		}
+
+		//same contract as above, but walks the adjacency snapshot so a query costs O((V + E)logV) instead of O(V^2)
+		static int calculate(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, int*& route)
+		{
+			RouteWorkspace ws;
+			return calculate(graph, isWeighted, origin, dst, route, ws);
+		}
+
+		//reuses the caller's workspace, so repeated queries don't allocate search state, Search::run picks the queue
+		static int calculate(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			if (!Search::run(graph, isWeighted, origin, dst, ws)) return 0; //out of memory, no route rather than a wrong one
+			return unwindRoute(ws.parents(), ws.isReached(dst) && !ws.isInterrupted() ? dst : -1, route);  //save route
+		}
+
+		//breadth first search for the unweighted metric, see Search::bfs
+		static int calculateBFS(const ds::CSRGraph& graph, const int origin, const int dst, int*& route, RouteWorkspace& ws, const bool directionOptimizing = false)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			if (!Search::bfs(graph, origin, dst, ws, directionOptimizing, [](const int, const int) { return Visit::Expand; })) return 0;
+			return unwindRoute(ws.parents(), ws.isReached(dst) && !ws.isInterrupted() ? dst : -1, route);  //save route
+		}
+
+		//A* search, vertices are ordered by cost so far plus a coordinate based lower bound of the remaining cost
+		//the bound is consistent, so every vertex is still settled at most once and the route stays optimal
+		static int calculateAStar(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			if (!ws.reset(size)) return 0;
+			ws.relax(origin, 0, -1);
+
+			//keyed by cost so far plus lower bound, the bound of a vertex never changes so a lower cost is a plain decrease key
+			ds::IndexedMinHeap<double>& minHeap = ws.boundHeap();
+			if (!minHeap.reset(size)) return 0;
+			minHeap.insert(origin, graph.lowerBound(origin, dst, isWeighted));
+			while (!minHeap.empty() && !ws.isInterrupted()) {
+				const int cur = minHeap.front().idx;
+				minHeap.pop();
+				ws.settle(cur);
+				if (cur == dst) break;
+				for (int e = graph.begin(cur); e < graph.end(cur); e++)
+				{
+					const int i = graph.targets[e];
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0 || ws.isSettled(i)) continue;  //not connected or visited
+					int dis = ws.dis(cur) + cost;
+					if (dis < ws.dis(i))
+					{
+						ws.relax(i, dis, cur);
+						minHeap.insert(i, dis + graph.lowerBound(i, dst, isWeighted));
+					}
+				}
+			}
+
+			return unwindRoute(ws.parents(), ws.isReached(dst) && !ws.isInterrupted() ? dst : -1, route);  //save route
+		}
+
+		//A* with the triangle inequality bounds of landmarks built for the same metric, falls back to calculate otherwise
+		//unlike calculateAStar it needs no coordinates, so it also tightens hop count queries
+		static int calculateALT(const ds::CSRGraph& graph, const bool isWeighted, const Landmarks& landmarks, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			if (!landmarks.isBuilt() || landmarks.size() != size || landmarks.isWeighted() != isWeighted) return calculate(graph, isWeighted, origin, dst, route, ws);
+			ds::IndexedMinHeap<int>& minHeap = ws.costHeap();
+			if (!ws.reset(size) || !minHeap.reset(size)) return 0;
+			ws.relax(origin, 0, -1);
+
+			minHeap.insert(origin, landmarks.lowerBound(origin, dst));
+			while (!minHeap.empty() && !ws.isInterrupted()) {
+				const int cur = minHeap.front().idx;
+				minHeap.pop();
+				ws.settle(cur);
+				if (cur == dst) break;
+				for (int e = graph.begin(cur); e < graph.end(cur); e++)
+				{
+					const int i = graph.targets[e];
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0 || ws.isSettled(i)) continue;  //not connected or visited
+					int dis = ws.dis(cur) + cost;
+					if (dis < ws.dis(i))
+					{
+						ws.relax(i, dis, cur);
+						minHeap.insert(i, dis + landmarks.lowerBound(i, dst));
+					}
+				}
+			}
+
+			return unwindRoute(ws.parents(), ws.isReached(dst) && !ws.isInterrupted() ? dst : -1, route);  //save route
+		}
+
+		//grows one search forward from origin and one backward from dst, expanding the side with the smaller tentative cost
+		//stops once the two heap minimums add up to at least the best meeting cost found so far
+		static int calculateBidirectional(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			RouteWorkspace& bws = ws.backward();
+			if (!ws.reset(size) || !bws.reset(size)) return 0;
+			ws.relax(origin, 0, -1);
+			bws.relax(dst, 0, -1);
+			if (origin == dst) return unwindRoute(ws.parents(), dst, route);
+
+			ds::IndexedMinHeap<int>& fwdHeap = ws.costHeap();
+			ds::IndexedMinHeap<int>& bwdHeap = bws.costHeap();
+			if (!fwdHeap.reset(size) || !bwdHeap.reset(size)) return 0;
+			fwdHeap.insert(origin, 0);
+			bwdHeap.insert(dst, 0);
+			int best = INT_MAX;
+			int meetFwd = -1;  //best route is origin ... meetFwd -> meetBwd ... dst
+			int meetBwd = -1;
+			while (!fwdHeap.empty() && !bwdHeap.empty() && !ws.isInterrupted()) {
+				if (fwdHeap.front().cost + bwdHeap.front().cost >= best) break; //no shorter route can be found
+				const bool isForward = fwdHeap.front().cost <= bwdHeap.front().cost;
+				auto& heap = isForward ? fwdHeap : bwdHeap;
+				RouteWorkspace& cur = isForward ? ws : bws;
+				RouteWorkspace& other = isForward ? bws : ws;
+				auto curNode = heap.front();
+				heap.pop();
+				cur.settle(curNode.idx);
+				for (int e = graph.begin(curNode.idx); e < graph.end(curNode.idx); e++)
+				{
+					const int i = graph.targets[e];
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0) continue;  //not connected
+					int dis = curNode.cost + cost;
+					if (other.isReached(i) && dis + other.dis(i) < best)  //the two searches meet on this arc
+					{
+						best = dis + other.dis(i);
+						meetFwd = isForward ? curNode.idx : i;
+						meetBwd = isForward ? i : curNode.idx;
+					}
+					if (cur.isSettled(i)) continue;
+					if (dis < cur.dis(i))
+					{
+						cur.relax(i, dis, curNode.idx);
+						heap.insert(i, dis);
+					}
+				}
+			}
+			if (best == INT_MAX || ws.isInterrupted()) return 0; //unreachable or given up
+
+			int fwdLen = 0;
+			int bwdLen = 0;
+			for (int v = meetFwd; v != -1; v = ws.parentOf(v)) fwdLen++;
+			for (int v = meetBwd; v != -1; v = bws.parentOf(v)) bwdLen++;
+			if (route == nullptr)
+				route = (int*)malloc((fwdLen + bwdLen) * sizeof(int));
+			if (route == nullptr) return 0;
+			int i = fwdLen;
+			for (int v = meetFwd; v != -1; v = ws.parentOf(v)) route[--i] = v;
+			i = fwdLen;
+			for (int v = meetBwd; v != -1; v = bws.parentOf(v)) route[i++] = v;  //backward parents point towards dst
+			return fwdLen + bwdLen;
+		}
+
+		//costs from every source to every target into result[s * targetCnt + t], INT_MAX where unreachable
+		//one search per source that stops once every target is settled, so all targets share it
+		//for many sources over a fixed graph, UpwardHierarchy::manyToMany shares the target side as well
+		static bool manyToMany(const ds::CSRGraph& graph, const bool isWeighted, const int* sources, const int sourceCnt,
+			const int* targets, const int targetCnt, int* result, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0 || sourceCnt < 0 || targetCnt < 0 || result == nullptr) return false; //size check
+			for (int k = 0; k < sourceCnt * targetCnt; k++) result[k] = INT_MAX;
+			for (int k = 0; k < sourceCnt; k++) if (sources[k] < 0 || sources[k] >= size) return false; //idx check
+			for (int k = 0; k < targetCnt; k++) if (targets[k] < 0 || targets[k] >= size) return false;
+
+			ds::Vector<bool> isTarget;
+			isTarget.resize(size, false);
+			int distinctTargets = 0;
+			for (int k = 0; k < targetCnt; k++)
+			{
+				if (isTarget[targets[k]]) continue;
+				isTarget[targets[k]] = true;
+				distinctTargets++;
+			}
+			if (distinctTargets == 0) return true;
+
+			for (int s = 0; s < sourceCnt; s++)
+			{
+				int pending = distinctTargets;
+				const bool isSearched = Search::run(graph, isWeighted, sources[s], -1, ws, [&](const int idx, const int) {
+					if (isTarget[idx] && --pending == 0) return Visit::Stop;
+					return Visit::Expand;
+				});
+				if (!isSearched) return false;
+				for (int t = 0; t < targetCnt; t++)
+					if (ws.isSettled(targets[t])) result[s * targetCnt + t] = ws.dis(targets[t]);
+			}
+			return true;
+		}
+
+		static int findRoute(const Router router, const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			switch (router)
+			{
+			case Router::AStar:
+				return calculateAStar(graph, isWeighted, origin, dst, route, ws);
+			case Router::Bidirectional:
+				return calculateBidirectional(graph, isWeighted, origin, dst, route, ws);
+			case Router::TransferAware:
+			{
+				ds::Vector<Leg> legs;
+				return TransferRouter::calculate(graph, isWeighted, origin, dst, 0, route, legs, ws);
+			}
+			case Router::ContractionHierarchy:  //one-off query, callers answering many should keep a built ContractionHierarchy instead
+			{
+				ContractionHierarchy hierarchy;
+				if (!hierarchy.build(graph, isWeighted)) return 0;
+				return hierarchy.calculate(origin, dst, route, ws);
+			}
+			case Router::ALT:
+			{
+				Landmarks landmarks;
+				landmarks.build(graph, isWeighted);
+				return calculateALT(graph, isWeighted, landmarks, origin, dst, route, ws);
+			}
+			case Router::RouteTable:
+			{
+				RouteTable table;
+				if (!table.build(graph, isWeighted)) return calculate(graph, isWeighted, origin, dst, route, ws);
+				return table.calculate(origin, dst, route);
+			}
+			case Router::CustomizableHierarchy:
+			{
+				CustomizableHierarchy hierarchy;
+				if (!hierarchy.build(graph) || hierarchy.customize(graph, isWeighted) == -1) return 0;
+				return hierarchy.calculate(origin, dst, route, ws);
+			}
+			case Router::Dijkstra:
+			default:
+				return calculate(graph, isWeighted, origin, dst, route, ws);
+			}
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "Search.hpp"
+#include "ContractionHierarchy.hpp"
+
+namespace Dijkstra
+{
+	constexpr int HUB_LABEL_BATCH_PER_THREAD = 16;  //roots searched per thread between two label merges, bigger batches prune a little less
+
+	//2-hop distance oracle (pruned landmark labeling): every station keeps a label of (hub, cost) pairs sorted by hub,
+	//such that any two stations share a hub on one of their cheapest routes, so a query is one merge join of two labels
+	//hubs are taken in contraction hierarchy order, most important first, and a search from a hub is pruned wherever
+	//the labels built so far already give the right cost
+	class HubLabels
+	{
+	public:
+		HubLabels() = default;
+		~HubLabels() { clear(); };
+
+		HubLabels(HubLabels&&) = delete;
+		HubLabels(const HubLabels&) = delete;
+		HubLabels& operator =(const HubLabels&) = delete;
+
+		//threadCnt 0 uses every hardware thread, roots are searched in batches whose searches only prune against earlier batches
+		bool build(const ds::CSRGraph& graph, const bool isWeighted, int threadCnt = 0)
+		{
+			clear();
+			const int size = graph.size();
+			if (size <= 0) return false; //size check
+			if (threadCnt <= 0) threadCnt = std::thread::hardware_concurrency();
+			if (threadCnt <= 0) threadCnt = 1;
+
+			ds::Vector<int> roots;  //stations by decreasing importance
+			{
+				ContractionHierarchy hierarchy;
+				if (!hierarchy.build(graph, isWeighted)) return false;
+				roots.resize(size);
+				for (int v = 0; v < size; v++) roots[size - 1 - hierarchy.rankOf(v)] = v;
+			}
+
+			ds::Vector<ds::Vector<Entry>> labels;  //growing labels, hubs are appended in increasing order
+			labels.resize(size);
+			const int maxBatch = threadCnt * HUB_LABEL_BATCH_PER_THREAD;
+			ds::Vector<ds::Vector<Entry>> found;  //stations labeled by each root of the batch, entry hub is the station here
+			found.resize(maxBatch);
+			ds::Vector<Worker*> workers;
+			for (int t = 0; t < threadCnt; t++) workers.push_back(new Worker(size));
+			std::atomic<bool> isFailed{ false };
+
+			for (int batchBegin = 0; batchBegin < size && !isFailed;)
+			{
+				int batch = batchBegin / 8;  //the first roots prune the most, so they go one by one
+				if (batch < 1) batch = 1;
+				if (batch > maxBatch) batch = maxBatch;
+				if (batch > size - batchBegin) batch = size - batchBegin;
+
+				std::atomic<int> next{ 0 };
+				auto work = [&](Worker* worker) {
+					for (int k = next++; k < batch; k = next++)
+						if (!prunedSearch(graph, isWeighted, labels, roots[batchBegin + k], *worker, found[k])) isFailed = true;
+				};
+				const int spawned = batch < threadCnt ? batch : threadCnt;
+				if (spawned <= 1) work(workers[0]);
+				else
+				{
+					ds::Vector<std::thread*> threads;
+					for (int t = 0; t < spawned; t++) threads.push_back(new std::thread(work, workers[t]));
+					for (auto thread : threads)
+					{
+						thread->join();
+						delete thread;
+					}
+				}
+
+				for (int k = 0; k < batch; k++)  //merge in root order, keeping every label sorted by hub
+				{
+					for (const auto& entry : found[k]) labels[entry.hub].push_back({ batchBegin + k, entry.cost });
+					found[k].resize(0);
+				}
+				batchBegin += batch;
+			}
+			for (auto worker : workers) delete worker;
+			found.clear_destruct();
+			if (isFailed)  //out of memory, labels with holes would give wrong costs
+			{
+				labels.clear_destruct();
+				return false;
+			}
+
+			this->offsets.resize(size + 1);
+			this->offsets[0] = 0;
+			for (int v = 0; v < size; v++) this->offsets[v + 1] = this->offsets[v] + labels[v].size();
+			this->hubs.resize(this->offsets[size]);
+			this->costs.resize(this->offsets[size]);
+			for (int v = 0; v < size; v++)
+			{
+				for (int k = 0; k < labels[v].size(); k++)
+				{
+					this->hubs[this->offsets[v] + k] = labels[v][k].hub;
+					this->costs[this->offsets[v] + k] = labels[v][k].cost;
+				}
+			}
+			labels.clear_destruct();
+			this->vexCnt = size;
+			this->weighted = isWeighted;
+			return true;
+		}
+
+		inline bool isBuilt() const {
+			return this->vexCnt > 0;
+		}
+
+		inline bool isWeighted() const {
+			return this->weighted;
+		}
+
+		inline int size() const {
+			return this->vexCnt;
+		}
+
+		//cost of the cheapest route, INT_MAX if dst can't be reached or an idx is out of range
+		int distance(const int origin, const int dst) const
+		{
+			if (origin < 0 || origin >= this->vexCnt || dst < 0 || dst >= this->vexCnt) return INT_MAX; //idx check
+			int i = this->offsets[origin];
+			int j = this->offsets[dst];
+			const int iEnd = this->offsets[origin + 1];
+			const int jEnd = this->offsets[dst + 1];
+			int best = INT_MAX;
+			while (i < iEnd && j < jEnd) {
+				if (this->hubs[i] < this->hubs[j]) i++;
+				else if (this->hubs[i] > this->hubs[j]) j++;
+				else
+				{
+					if (this->costs[i] + this->costs[j] < best) best = this->costs[i] + this->costs[j];
+					i++;
+					j++;
+				}
+			}
+			return best;
+		}
+
+		inline int labelSize(const int idx) const {
+			return this->offsets[idx + 1] - this->offsets[idx];
+		}
+
+		//(hub, cost) pairs over all labels
+		inline int entryCnt() const {
+			return this->hubs.size();
+		}
+
+		//bytes held by the labels and their offsets
+		inline size_t memoryBytes() const {
+			return (size_t)this->hubs.size_in_bytes() + this->costs.size_in_bytes() + this->offsets.size_in_bytes();
+		}
+
+		void clear()
+		{
+			this->vexCnt = 0;
+			this->weighted = false;
+			this->offsets.clear();
+			this->hubs.clear();
+			this->costs.clear();
+		}
+
+	private:
+		struct Entry
+		{
+			int hub;
+			int cost;
+		};
+
+		//search state owned by one build thread
+		struct Worker
+		{
+			Worker(const int size)
+			{
+				rootCosts.resize(size, INT_MAX);
+			}
+
+			RouteWorkspace ws;
+			ds::Vector<int> rootCosts;  //cost from the current root to each hub of its label, INT_MAX elsewhere
+		};
+
+		//search from root that stops at stations whose cost the existing labels already cover, found receives the other stations
+		//returns false if the search ran out of memory
+		static bool prunedSearch(const ds::CSRGraph& graph, const bool isWeighted, const ds::Vector<ds::Vector<Entry>>& labels,
+			const int root, Worker& worker, ds::Vector<Entry>& found)
+		{
+			for (const auto& entry : labels[root]) worker.rootCosts[entry.hub] = entry.cost;
+			const bool isSearched = Search::run(graph, isWeighted, root, -1, worker.ws, [&](const int idx, const int cost) {
+				for (const auto& entry : labels[idx])
+				{
+					const int rootCost = worker.rootCosts[entry.hub];
+					if (rootCost != INT_MAX && rootCost + entry.cost <= cost) return Visit::Prune;  //covered
+				}
+				found.push_back({ idx, cost });
+				return Visit::Expand;
+			});
+			for (const auto& entry : labels[root]) worker.rootCosts[entry.hub] = INT_MAX;
+			return isSearched;
+		}
+
+	private:
+		int vexCnt{ 0 };
+		bool weighted{ false };
+		ds::Vector<int> offsets;  //label of station v is hubs/costs[offsets[v]] ... [offsets[v + 1] - 1], sorted by hub
+		ds::Vector<int> hubs;  //hubs are identified by their position in the order, not by station index
+		ds::Vector<int> costs;
+	};
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <iostream>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "Search.hpp"
+
+namespace Dijkstra
+{
+	constexpr int DEFAULT_LANDMARK_CNT = 8;
+
+	//landmarks for goal directed searches (ALT): exact costs from a few stations to every station
+	//the graph is symmetric, so by the triangle inequality |d(L, v) - d(L, dst)| never overestimates the cost from v to dst
+	//building is one Dijkstra per landmark, cheap enough to redo whenever costs change, and bounds stay valid as long as costs only grow
+	class Landmarks
+	{
+	public:
+		enum class Selection
+		{
+			Farthest,  //each landmark is the station farthest from the ones already chosen
+			Avoid,  //each landmark sits below the subtree whose routes the current landmarks bound worst
+		};
+
+		Landmarks() = default;
+		~Landmarks() { clear(); };
+
+		Landmarks(Landmarks&&) = delete;
+		Landmarks(const Landmarks&) = delete;
+		Landmarks& operator =(const Landmarks&) = delete;
+
+		bool build(const ds::CSRGraph& graph, const bool isWeighted, int landmarkCnt = DEFAULT_LANDMARK_CNT, const Selection selection = Selection::Avoid)
+		{
+			clear();
+			const int size = graph.size();
+			if (size <= 0 || landmarkCnt <= 0) return false; //size check
+			if (landmarkCnt > size) landmarkCnt = size;
+
+			ds::Vector<int> dis;
+			ds::Vector<int> parent;
+			ds::Vector<int> order;
+			ds::Vector<int> minDis;  //cost from every station to its nearest landmark, the farthest selection picks its maximum
+			dis.resize(size);
+			parent.resize(size);
+			order.resize(size);
+			minDis.resize(size, INT_MAX);
+			RouteWorkspace ws;
+			this->vexCnt = size;
+			this->weighted = isWeighted;
+			this->dist.resize(size * landmarkCnt);
+
+			oneToAll(graph, isWeighted, 0, ws, dis.begin(), parent.begin(), order.begin());
+			int next = farthestOf(dis.begin(), size);  //farthest from an arbitrary start, a periphery station
+			for (int k = 0; k < landmarkCnt; k++)
+			{
+				this->landmarks.push_back(next);
+				oneToAll(graph, isWeighted, next, ws, dis.begin(), parent.begin(), order.begin());
+				for (int v = 0; v < size; v++)
+				{
+					this->dist[v * landmarkCnt + k] = dis[v];
+					if (dis[v] < minDis[v]) minDis[v] = dis[v];
+				}
+				if (k + 1 == landmarkCnt) break;
+
+				next = -1;
+				if (selection == Selection::Avoid)
+				{
+					const int root = (int)(((uint32_t)(k + 1) * 2654435761u) % (uint32_t)size);
+					const int reached = oneToAll(graph, isWeighted, root, ws, dis.begin(), parent.begin(), order.begin());
+					next = avoid(dis.begin(), parent.begin(), order.begin(), reached, root, k + 1, landmarkCnt);
+				}
+				if (next == -1) next = farthestOf(minDis.begin(), size);
+				if (next == -1) break;  //every station is a landmark already
+			}
+			this->landmarkCnt = landmarkCnt;
+			if (this->landmarks.size() < landmarkCnt) //compact the table to the landmarks actually chosen
+			{
+				const int chosen = this->landmarks.size();
+				for (int v = 0; v < size; v++)
+					for (int k = 0; k < chosen; k++) this->dist[v * chosen + k] = this->dist[v * landmarkCnt + k];
+				this->dist.resize(size * chosen);
+				this->landmarkCnt = chosen;
+			}
+			return true;
+		}
+
+		inline bool isBuilt() const {
+			return this->vexCnt > 0;
+		}
+
+		inline bool isWeighted() const {
+			return this->weighted;
+		}
+
+		inline int size() const {
+			return this->vexCnt;
+		}
+
+		inline int count() const {
+			return this->landmarkCnt;
+		}
+
+		inline int landmarkAt(const int k) const {
+			return this->landmarks[k];
+		}
+
+		//admissible and consistent lower bound of the cost from idx to dst
+		inline int lowerBound(const int idx, const int dst) const
+		{
+			const int* a = &this->dist[idx * this->landmarkCnt];
+			const int* b = &this->dist[dst * this->landmarkCnt];
+			int bound = 0;
+			for (int k = 0; k < this->landmarkCnt; k++)
+			{
+				if (a[k] == INT_MAX || b[k] == INT_MAX) continue;  //landmark can't reach both, it tells nothing
+				const int diff = a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+				if (diff > bound) bound = diff;
+			}
+			return bound;
+		}
+
+		void clear()
+		{
+			this->vexCnt = 0;
+			this->landmarkCnt = 0;
+			this->weighted = false;
+			this->landmarks.clear();
+			this->dist.clear();
+		}
+
+	private:
+		//search over the whole graph, dis is INT_MAX where unreachable, order receives the stations in settle order
+		//returns the number of stations reached
+		static int oneToAll(const ds::CSRGraph& graph, const bool isWeighted, const int origin, RouteWorkspace& ws, int* dis, int* parent, int* order)
+		{
+			int reached = 0;
+			const bool isSearched = Search::run(graph, isWeighted, origin, -1, ws, [&](const int idx, const int) {
+				order[reached++] = idx;
+				return Visit::Expand;
+			});
+			for (int v = 0; v < graph.size(); v++)  //a search that ran out of memory reaches nothing
+			{
+				dis[v] = isSearched ? ws.dis(v) : INT_MAX;
+				parent[v] = isSearched ? ws.parentOf(v) : -1;
+			}
+			return isSearched ? reached : 0;
+		}
+
+		//station maximizing dis that isn't a landmark yet, unreachable stations come first, -1 if there is none
+		int farthestOf(const int* dis, const int size) const
+		{
+			int best = -1;
+			for (int v = 0; v < size; v++)
+			{
+				if (this->landmarks.contains(v)) continue;
+				if (best == -1 || dis[v] > dis[best]) best = v;
+			}
+			return best;
+		}
+
+		//avoid heuristic on the shortest path tree of root: a station weighs how much the chosen landmarks underestimate its cost from root,
+		//subtrees holding a landmark weigh nothing, and the new landmark is the leaf reached from the heaviest subtree by always taking the heaviest child
+		int avoid(const int* dis, const int* parent, const int* order, const int reached, const int root, const int chosen, const int stride) const
+		{
+			ds::Vector<int64_t> weight;
+			ds::Vector<int> heaviestChild;
+			weight.resize(this->vexCnt, 0);
+			heaviestChild.resize(this->vexCnt, -1);
+			ds::Vector<bool> isCovered;  //subtree holds a landmark
+			isCovered.resize(this->vexCnt, false);
+			for (int k = 0; k < chosen; k++) isCovered[this->landmarks[k]] = true;
+
+			for (int j = reached - 1; j >= 0; j--)  //children are settled after their parent
+			{
+				const int v = order[j];
+				int bound = 0;
+				for (int k = 0; k < chosen; k++)
+				{
+					const int a = this->dist[v * stride + k];
+					const int b = this->dist[root * stride + k];
+					if (a == INT_MAX || b == INT_MAX) continue;
+					const int diff = a > b ? a - b : b - a;
+					if (diff > bound) bound = diff;
+				}
+				weight[v] += dis[v] - bound;
+				if (isCovered[v]) weight[v] = 0;
+				const int p = parent[v];
+				if (p == -1) continue;
+				if (isCovered[v]) isCovered[p] = true;
+				weight[p] += weight[v];
+				if (heaviestChild[p] == -1 || weight[v] > weight[heaviestChild[p]]) heaviestChild[p] = v;
+			}
+			int v = -1;  //descend from the heaviest subtree
+			for (int j = 0; j < reached; j++)
+				if (v == -1 || weight[order[j]] > weight[v]) v = order[j];
+			if (v == -1 || weight[v] <= 0) return -1;
+			while (heaviestChild[v] != -1 && weight[heaviestChild[v]] > 0) v = heaviestChild[v];
+			return this->landmarks.contains(v) ? -1 : v;
+		}
+
+	private:
+		int vexCnt{ 0 };
+		int landmarkCnt{ 0 };
+		bool weighted{ false };
+		ds::Vector<int> landmarks;
+		ds::Vector<int> dist;  //cost from landmark k to station v is dist[v * landmarkCnt + k], INT_MAX if unreachable
+	};
+}
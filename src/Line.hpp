@@ -0,0 +1,394 @@
+#pragma once
+
+#include <cstdint>
+#include "Vector.hpp"
+#include "LineSet.hpp"
+#include "CSRGraph.hpp"
+
+namespace ds
+{
+	//one line as ordered stop sequences, a stop is a position in stops, so neighbouring stops are neighbouring positions
+	//every branch runs from a terminal to a terminal: a branch leaving another one repeats its stops up to the junction,
+	//once from either end, so a ride never has to switch branches, and a loop is a single branch whose last stop is followed by its first
+	class Line
+	{
+	public:
+		inline int stopCnt() const {
+			return this->stops.size();
+		}
+
+		inline int branchCnt() const {
+			return this->branchBegins.size() > 0 ? this->branchBegins.size() - 1 : 0;
+		}
+
+		inline int branchBegin(const int branch) const {
+			return this->branchBegins[branch];
+		}
+
+		inline int branchEnd(const int branch) const {
+			return this->branchBegins[branch + 1];
+		}
+
+		inline bool isLoop(const int branch) const {
+			return this->isLoopBranch[branch];
+		}
+
+		inline int branchOf(const int stop) const {
+			return this->branchOfStop[stop];
+		}
+
+		inline int stationAt(const int stop) const {
+			return this->stops[stop];
+		}
+
+		//following stop on the same branch, -1 at a terminal
+		inline int next(const int stop) const {
+			const int branch = this->branchOfStop[stop];
+			if (stop + 1 < this->branchBegins[branch + 1]) return stop + 1;
+			return this->isLoopBranch[branch] ? this->branchBegins[branch] : -1;
+		}
+
+		//stop before on the same branch, -1 at a terminal
+		inline int prev(const int stop) const {
+			const int branch = this->branchOfStop[stop];
+			if (stop > this->branchBegins[branch]) return stop - 1;
+			return this->isLoopBranch[branch] ? this->branchBegins[branch + 1] - 1 : -1;
+		}
+
+		//stop reached riding count stops from stop, towards the branch end if count is positive, -1 past a terminal
+		inline int ride(const int stop, const int count) const {
+			const int branch = this->branchOfStop[stop];
+			const int begin = this->branchBegins[branch];
+			const int len = this->branchBegins[branch + 1] - begin;
+			if (this->isLoopBranch[branch]) return begin + ((stop - begin + count) % len + len) % len;
+			const int to = stop + count;
+			return to >= begin && to < begin + len ? to : -1;
+		}
+
+		//fewest stops ridden between two stops of one branch, -1 if they are on different branches
+		inline int stopsBetween(const int from, const int to) const {
+			const int branch = this->branchOfStop[from];
+			if (this->branchOfStop[to] != branch) return -1;
+			const int dis = to > from ? to - from : from - to;
+			if (!this->isLoopBranch[branch]) return dis;
+			const int len = this->branchBegins[branch + 1] - this->branchBegins[branch];
+			return dis < len - dis ? dis : len - dis;
+		}
+
+	private:
+		friend class LineNetwork;
+
+		void clear() {
+			this->stops.resize(0);
+			this->branchBegins.resize(0);
+			this->branchOfStop.resize(0);
+			this->isLoopBranch.resize(0);
+		}
+
+		ds::Vector<int> stops;  //station of each stop, branch b holds stops branchBegins[b] ... branchBegins[b + 1] - 1
+		ds::Vector<int> branchBegins;  //branchCnt() + 1 entries
+		ds::Vector<int> branchOfStop;
+		ds::Vector<bool> isLoopBranch;
+	};
+
+	//the stop sequences of every line of a graph, and the stops at each station, which is what RAPTOR style routers scan
+	//built from the arcs each line runs on: O(stations + arcs) per line
+	class LineNetwork
+	{
+	public:
+		struct StopRef
+		{
+			int line;
+			int stop;
+		};
+
+		LineNetwork() = default;
+		~LineNetwork() = default;
+
+		LineNetwork(LineNetwork&&) = delete;
+		LineNetwork(const LineNetwork&) = delete;
+		LineNetwork& operator =(const LineNetwork&) = delete;
+
+		//orders the stations of every line in lineNums, stationsOf(line) lists the stations on it in any order
+		template<typename StationsOf>
+		void build(const CSRGraph& graph, const LineSet& lineNums, StationsOf&& stationsOf)
+		{
+			clear();
+			this->localOf.resize(graph.size(), -1);
+			for (auto line : lineNums)
+			{
+				const ds::Vector<int>& stations = stationsOf(line);
+				order(graph, line, stations, this->lines[line]);
+				this->builtLines.insert(line);
+			}
+			index(graph.size());
+		}
+
+		void clear()
+		{
+			for (auto line : this->builtLines) this->lines[line].clear();
+			this->builtLines = LineSet();
+			this->stationOffsets.resize(0);
+			this->stationStops.resize(0);
+		}
+
+		inline const LineSet& getLines() const {
+			return this->builtLines;
+		}
+
+		//empty if line has no stations
+		inline const Line& lineAt(const int line) const {
+			static const Line none;
+			return this->builtLines.contains(line) ? this->lines[line] : none;
+		}
+
+		//stops of every line at station, ordered by line then stop
+		inline int stopsAt(const int station, const StopRef*& first) const {
+			if (station < 0 || station + 1 >= this->stationOffsets.size()) return 0;
+			first = this->stationStops.begin() + this->stationOffsets[station];
+			return this->stationOffsets[station + 1] - this->stationOffsets[station];
+		}
+
+		//first stop of station on line, -1 if the line doesn't stop there
+		inline int stopOf(const int line, const int station) const {
+			const StopRef* first = nullptr;
+			const int cnt = stopsAt(station, first);
+			for (int i = 0; i < cnt; i++)
+				if (first[i].line == line) return first[i].stop;
+			return -1;
+		}
+
+		//stops of one branch of line riding from station from to station to, the one with the fewest stops in between
+		//returns false if no branch of line serves both
+		bool findRide(const int line, const int from, const int to, int& fromStop, int& toStop) const
+		{
+			const Line& l = lineAt(line);
+			const StopRef* froms = nullptr;
+			const StopRef* tos = nullptr;
+			const int fromCnt = stopsAt(from, froms);
+			const int toCnt = stopsAt(to, tos);
+			int best = -1;
+			for (int i = 0; i < fromCnt; i++)
+			{
+				if (froms[i].line != line) continue;
+				for (int j = 0; j < toCnt; j++)
+				{
+					if (tos[j].line != line) continue;
+					const int stops = l.stopsBetween(froms[i].stop, tos[j].stop);
+					if (stops < 0 || (best != -1 && stops >= best)) continue;
+					best = stops;
+					fromStop = froms[i].stop;
+					toStop = tos[j].stop;
+				}
+			}
+			return best != -1;
+		}
+
+	private:
+		//splits the arcs line runs on into a trunk and the branches leaving it
+		void order(const CSRGraph& graph, const int line, const ds::Vector<int>& stations, Line& result)
+		{
+			const uint64_t bit = 1ull << line;
+			const int size = stations.size();
+			for (int k = 0; k < size; k++) this->localOf[stations[k]] = k;
+
+			//arcs of the line between its own stations, once per neighbour
+			this->adjOffsets.resize(size + 1);
+			this->adj.resize(0);
+			for (int k = 0; k < size; k++)
+			{
+				this->adjOffsets[k] = this->adj.size();
+				for (int e = graph.begin(stations[k]); e < graph.end(stations[k]); e++)
+				{
+					const int local = this->localOf[graph.targets[e]];
+					if ((graph.lineMasks[e] & bit) == 0 || local < 0 || local == k) continue;
+					bool isKnown = false;
+					for (int i = this->adjOffsets[k]; i < this->adj.size() && !isKnown; i++) isKnown = this->adj[i] == local;
+					if (!isKnown) this->adj.push_back(local);
+				}
+			}
+			this->adjOffsets[size] = this->adj.size();
+			this->isArcUsed.resize(0);
+			this->isArcUsed.resize(this->adj.size(), false);
+			this->isPlaced.resize(0);
+			this->isPlaced.resize(size, false);
+
+			int branch = 0;
+			for (int k = 0; k < size; k++)  //once per connected part of the line
+			{
+				if (this->isPlaced[k]) continue;
+				result.branchBegins.push_back(result.stops.size());
+				const int last = farthest(farthest(k));
+				if (this->isRing)  //a loop line, ridden all the way round
+				{
+					result.stops.push_back(k);
+					this->isPlaced[k] = true;
+					walk(result, k);
+				}
+				else  //the trunk is the longest shortest path, so short spurs don't cut it off
+				{
+					const int first = result.stops.size();
+					for (int v = last; v != -1; v = this->parents[v])
+					{
+						result.stops.push_back(v);
+						this->isPlaced[v] = true;
+						if (this->parents[v] != -1) useArc(v, this->parents[v]);
+					}
+					for (int i = first, j = result.stops.size() - 1; i < j; i++, j--)
+					{
+						const int s = result.stops[i];
+						result.stops[i] = result.stops[j];
+						result.stops[j] = s;
+					}
+					result.isLoopBranch.push_back(false);
+				}
+				for (; branch < result.branchBegins.size(); branch++)  //branches leaving this one, and the ones leaving those
+				{
+					for (int stop = result.branchBegins[branch]; stop < endOf(result, branch); stop++)
+					{
+						const int junction = result.stops[stop];
+						while (hasFreeArc(junction))
+						{
+							const int begin = result.branchBegins[branch];
+							const int end = endOf(result, branch);
+							const int leaving = result.stops.size() + stop - begin;  //the junction in the new branch
+							result.branchBegins.push_back(result.stops.size());
+							for (int i = begin; i <= stop; i++)
+							{
+								const int s = result.stops[i];
+								result.stops.push_back(s);
+							}
+							const bool isClosed = walk(result, junction);
+							if (isClosed || result.isLoopBranch[branch] || result.isLoopBranch.back() || stop + 1 == end) continue;
+
+							//trains also run from the other end of the branch onto the new one
+							const int leftEnd = result.stops.size();
+							result.branchBegins.push_back(result.stops.size());
+							for (int i = end - 1; i >= stop; i--)
+							{
+								const int s = result.stops[i];
+								result.stops.push_back(s);
+							}
+							for (int i = leaving + 1; i < leftEnd; i++)
+							{
+								const int s = result.stops[i];
+								result.stops.push_back(s);
+							}
+							result.isLoopBranch.push_back(false);
+						}
+					}
+				}
+			}
+			result.branchBegins.push_back(result.stops.size());
+
+			for (int b = 0; b < result.branchCnt(); b++)
+				for (int stop = result.branchBegins[b]; stop < result.branchBegins[b + 1]; stop++) result.branchOfStop.push_back(b);
+			for (auto& stop : result.stops) stop = stations[stop];
+			for (int k = 0; k < size; k++) this->localOf[stations[k]] = -1;
+		}
+
+		//extends the last branch from local station cur along arcs not ridden yet, marks it a loop if it gets back to its start
+		//returns whether it ran into a station of the line placed before
+		bool walk(Line& result, int cur)
+		{
+			const int branchStart = result.stops[result.branchBegins.back()];
+			bool isLoop = false;
+			bool isClosed = false;
+			while (true) {
+				int arc = -1;
+				for (int i = this->adjOffsets[cur]; i < this->adjOffsets[cur + 1] && arc == -1; i++)
+					if (!this->isArcUsed[i]) arc = i;
+				if (arc == -1) break;
+				const int next = this->adj[arc];
+				useArc(cur, next);
+				if (next == branchStart && result.stops.size() - result.branchBegins.back() > 2)
+				{
+					isLoop = true;
+					break;
+				}
+				result.stops.push_back(next);
+				isClosed = this->isPlaced[next];
+				if (isClosed) break;  //ran into the line again, the branch ends there
+				this->isPlaced[next] = true;
+				cur = next;
+			}
+			result.isLoopBranch.push_back(isLoop);
+			return isClosed;
+		}
+
+		//farthest local station from start in stops, on the way parents receives the BFS tree rooted at start
+		//and isRing whether every station reached has exactly two neighbours
+		int farthest(const int start)
+		{
+			const int size = this->adjOffsets.size() - 1;
+			this->parents.resize(0);
+			this->parents.resize(size, -2);  //-2 while not reached
+			this->queue.resize(0);
+			this->queue.push_back(start);
+			this->parents[start] = -1;
+			this->isRing = true;
+			for (int head = 0; head < this->queue.size(); head++)
+			{
+				const int cur = this->queue[head];
+				if (this->adjOffsets[cur + 1] - this->adjOffsets[cur] != 2) this->isRing = false;
+				for (int i = this->adjOffsets[cur]; i < this->adjOffsets[cur + 1]; i++)
+				{
+					const int next = this->adj[i];
+					if (this->parents[next] != -2) continue;
+					this->parents[next] = cur;
+					this->queue.push_back(next);
+				}
+			}
+			return this->queue.back();
+		}
+
+		inline void useArc(const int u, const int v) {
+			for (int i = this->adjOffsets[u]; i < this->adjOffsets[u + 1]; i++)
+				if (this->adj[i] == v) this->isArcUsed[i] = true;
+			for (int i = this->adjOffsets[v]; i < this->adjOffsets[v + 1]; i++)
+				if (this->adj[i] == u) this->isArcUsed[i] = true;
+		}
+
+		inline bool hasFreeArc(const int local) const {
+			for (int i = this->adjOffsets[local]; i < this->adjOffsets[local + 1]; i++)
+				if (!this->isArcUsed[i]) return true;
+			return false;
+		}
+
+		//branch may still be growing while the branches before it are split
+		static inline int endOf(const Line& line, const int branch) {
+			return branch + 1 < line.branchBegins.size() ? line.branchBegins[branch + 1] : line.stops.size();
+		}
+
+		void index(const int size)
+		{
+			this->stationOffsets.resize(size + 1, 0);
+			for (auto line : this->builtLines)
+				for (auto station : this->lines[line].stops) this->stationOffsets[station + 1]++;
+			for (int i = 0; i < size; i++) this->stationOffsets[i + 1] += this->stationOffsets[i];
+			this->stationStops.resize(this->stationOffsets[size]);
+			ds::Vector<int> cursor;
+			cursor.resize(size);
+			for (int i = 0; i < size; i++) cursor[i] = this->stationOffsets[i];
+			for (auto line : this->builtLines)
+				for (int stop = 0; stop < this->lines[line].stopCnt(); stop++)
+					this->stationStops[cursor[this->lines[line].stops[stop]]++] = { line, stop };
+		}
+
+	private:
+		Line lines[MAX_LINES];  //indexed by line number
+		LineSet builtLines;
+		ds::Vector<int> stationOffsets;  //stops at station i are stationStops[stationOffsets[i]] ... stationStops[stationOffsets[i + 1] - 1]
+		ds::Vector<StopRef> stationStops;
+
+		//scratch of order(), local indexes are positions in the station list of the line
+		ds::Vector<int> localOf;
+		ds::Vector<int> adjOffsets;
+		ds::Vector<int> adj;
+		ds::Vector<bool> isArcUsed;
+		ds::Vector<bool> isPlaced;
+		ds::Vector<int> parents;
+		ds::Vector<int> queue;
+		bool isRing{ false };
+	};
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ds
+{
+	constexpr int MAX_LINES = 64;  //line numbers are kept as bits of a uint64_t mask
+	constexpr int WALK_LINE = MAX_LINES - 1;  //reserved for arcs no line runs on, riding it means walking between stations
+
+	//whether a station or an arc may be put on line, WALK_LINE is never a real line
+	inline bool isRideLine(const int line)
+	{
+		return line >= 0 && line < WALK_LINE;
+	}
+
+	inline int popcount(uint64_t x)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return (int)__popcnt64(x);
+#elif defined(__GNUC__)
+		return __builtin_popcountll(x);
+#else
+		x = x - ((x >> 1) & 0x5555555555555555ull);
+		x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+		x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+	}
+
+	//lowest line set in mask, -1 if there is none
+	inline int lowestLine(uint64_t mask)
+	{
+		if (mask == 0) return -1;
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long line;
+		_BitScanForward64(&line, mask);
+		return (int)line;
+#elif defined(__GNUC__)
+		return __builtin_ctzll(mask);
+#else
+		int line = 0;
+		while ((mask & 1) == 0)
+		{
+			mask >>= 1;
+			line++;
+		}
+		return line;
+#endif
+	}
+
+	//lines a station or an arc belongs to, one bit per line number, so no heap memory and shared lines are a single AND
+	//iterates its lines in increasing order
+	struct LineSet
+	{
+		class Iterator
+		{
+		public:
+			explicit Iterator(const uint64_t rest) : rest(rest) {}
+			inline int operator*() const { return lowestLine(this->rest); }
+			inline Iterator& operator++() { this->rest &= this->rest - 1; return *this; }
+			inline bool operator!=(const Iterator& other) const { return this->rest != other.rest; }
+
+		private:
+			uint64_t rest;  //lines not visited yet
+		};
+
+		LineSet() = default;
+		explicit LineSet(const uint64_t mask) : mask(mask) {}
+
+		//lines out of 0 .. MAX_LINES - 1 can't be kept and are refused
+		inline bool insert(const int line) {
+			if (line < 0 || line >= MAX_LINES) return false;
+			this->mask |= 1ull << line;
+			return true;
+		}
+
+		inline void erase(const int line) {
+			if (line >= 0 && line < MAX_LINES) this->mask &= ~(1ull << line);
+		}
+
+		inline bool contains(const int line) const {
+			return line >= 0 && line < MAX_LINES && (this->mask & (1ull << line)) != 0;
+		}
+
+		inline int size() const {
+			return popcount(this->mask);
+		}
+
+		inline bool empty() const {
+			return this->mask == 0;
+		}
+
+		//lowest line, -1 if empty
+		inline int front() const {
+			return lowestLine(this->mask);
+		}
+
+		inline LineSet operator&(const LineSet& other) const {
+			return LineSet(this->mask & other.mask);
+		}
+
+		inline LineSet& operator|=(const LineSet& other) {
+			this->mask |= other.mask;
+			return *this;
+		}
+
+		inline bool operator==(const LineSet& other) const {
+			return this->mask == other.mask;
+		}
+
+		inline bool operator!=(const LineSet& other) const {
+			return this->mask != other.mask;
+		}
+
+		inline Iterator begin() const {
+			return Iterator(this->mask);
+		}
+
+		inline Iterator end() const {
+			return Iterator(0);
+		}
+
+		uint64_t mask{ 0 };
+	};
+}
@@ -4,6 +4,8 @@
 #include "font/font.hpp"
 #include "SubwayGraph.hpp"
 #include "Dijkstra.hpp"
+#include "RouteCache.hpp"
+#include "RouteWorker.hpp"
 
 class Menu
 {
@@ -36,6 +38,22 @@ private:
         return val * zoomScale;
     }
 
+    inline uint64_t ignoredLineMask() const {
+        uint64_t mask = 0;
+        for (int i = 0; i < isRailwayLineIgnored.size() && i < ds::WALK_LINE; i++)
+            if (isRailwayLineIgnored[i]) mask |= 1ull << i;
+        return mask;
+    }
+
+    //preprocessed routers are tied to the graph they were built on, checked before every query so no edit can leave them stale
+    inline void syncGraphVersion() {
+        if (this->preprocessedVersion == g_graph->getVersion()) return;
+        this->preprocessedVersion = g_graph->getVersion();
+        for (auto& hierarchy : this->contractionHierarchies) hierarchy.clear();
+        for (auto& landmarks : this->landmarks) landmarks.clear();  //a rebuild is only K searches
+        this->isMetricStale = true;  //the customizable hierarchy keeps its topology and only picks up the new costs
+    }
+
     static void helpMarker(const char* desc) {
         ImGui::TextDisabled("(?)");
         if (ImGui::IsItemHovered())
@@ -116,86 +134,68 @@ private:
         return r;
     }
 
-    inline void searchForBestTransferRoute(
-        ds::Vector<int> transferAt,
-        ds::Vector<int> bestTransfer,
-        ds::Vector<int>& transferAtResult,
-        ds::Vector<int>& bestTransferResult,
-        int& minTransfers,
-        int curLine,
-        int curVexIdx,
-        int transferCnt
-        )
+    //unmarks and frees the route on screen
+    inline void clearRoute()
     {
-        if (curVexIdx >= this->routeLen - 1)
-        {
-            if (transferCnt < minTransfers)
-            {
-                minTransfers = transferCnt;
-                transferAtResult = transferAt;
-                bestTransferResult = bestTransfer;
-            }
-            return;
-        }
-
-        auto vex = g_graph->vexAt(route[curVexIdx]);
-        ds::Arc* arc = vex.first;
-        for (arc; arc != nullptr; arc = arc->next) if (arc->adjVex == route[curVexIdx + 1]) break;
-        if (arc == nullptr) {
-            for (arc = g_graph->vexAt(route[curVexIdx + 1]).first; arc != nullptr; arc = arc->next) if (arc->adjVex == route[curVexIdx]) break;
-        }
-
-        if (arc == nullptr) {
-            minTransfers = -1;
-            return;
-        }
+        if (this->route == nullptr) return;
+        for (int i = 0; i < this->routeLen; i++) this->isVexInRoute[route[i]] = false;  //only unmark the last route
+        free(this->route);
+        this->route = nullptr;
+        this->routeLen = 0;
+    }
 
-        for (auto line : arc->lineNum)
-        {
-            if (line != curLine)
-            {
-                transferAt.push_back(route[curVexIdx]);
-                bestTransfer.push_back(line);
-                searchForBestTransferRoute(transferAt, bestTransfer, transferAtResult, bestTransferResult, minTransfers, line, curVexIdx + 1, transferCnt + 1);
-                transferAt.pop_back();
-                bestTransfer.pop_back(); 
-            }
-            else {
-                searchForBestTransferRoute(transferAt, bestTransfer, transferAtResult, bestTransferResult, minTransfers, curLine, curVexIdx + 1, transferCnt);
-            }
+    inline void markRoute()
+    {
+        if (this->isVexInRoute.size() < g_graph->size() + 8) this->isVexInRoute.resize(g_graph->size() + 8, false);
+        for (int i = 0; i < this->routeLen; i++) {
+            this->isVexInRoute[route[i]] = true;
         }
-
     }
 
-    inline void printRoute()
+    inline void printRoute(const ds::Vector<Dijkstra::Leg>& legs)
     {
         if (route == nullptr) return;
-        ds::Vector<int> transferAt;
-        ds::Vector<int> bestTransfer;
-        int minTransfers = INT_MAX;
         transferAtResult.clear();
         bestTransferResult.clear();
-        searchForBestTransferRoute(transferAt, bestTransfer, transferAtResult, bestTransferResult, minTransfers, 0, 0, 0);
+        for (auto& leg : legs)
+        {
+            transferAtResult.push_back(leg.from);
+            bestTransferResult.push_back(leg.line);
+        }
+        printTransfers(legs.size());
+    }
+
+    //"N" for a ride, walking for a leg over arcs no line runs on
+    template<size_t N>
+    static const char* lineLabel(char (&buf)[N], const int line) {
+        if (line == ds::WALK_LINE) sprintf_s(buf, "%s", u8"");
+        else sprintf_s(buf, "%d%s", line, u8"");
+        return buf;
+    }
 
+    inline void printTransfers(const int minTransfers)
+    {
         if (minTransfers == 0) {
             LOG(u8"[Info] վյվͬ\n");
             return;
         }
 
-        if (minTransfers == -1) {
-            LOG("[Error] Unexpected error occured while finding best transfer route...\n");
-            return;
-        }
-
         LOG("[Info] %s", u8"ѯ·Ϣ£\n");
-        LOG("[Info] %s: %s%s%d%s\n", u8"վ", string2UTF8(g_graph->vexAt(transferAtResult[0]).name).c_str(), u8"ϳ", bestTransferResult[0], u8"");
+        char from[32], to[32];
+        if (bestTransferResult[0] == ds::WALK_LINE)
+            LOG("[Info] %s: %s%s\n", u8"վ", string2UTF8(g_graph->vexAt(transferAtResult[0]).name).c_str(), u8"");
+        else
+            LOG("[Info] %s: %s%s%d%s\n", u8"վ", string2UTF8(g_graph->vexAt(transferAtResult[0]).name).c_str(), u8"ϳ", bestTransferResult[0], u8"");
 
         for (int i = 1; i < minTransfers; i++)
         {
-            LOG("[Info] %s: %s %d%s --> %d%s\n", u8"վ", string2UTF8(g_graph->vexAt(transferAtResult[i]).name).c_str(), bestTransferResult[i - 1], u8"", bestTransferResult[i], u8"");
+            LOG("[Info] %s: %s %s --> %s\n", u8"վ", string2UTF8(g_graph->vexAt(transferAtResult[i]).name).c_str(), lineLabel(from, bestTransferResult[i - 1]), lineLabel(to, bestTransferResult[i]));
         }
 
-        LOG("[Info] %s: %s%s%d%s\n", u8"յվ", string2UTF8(g_graph->vexAt(route[routeLen - 1]).name).c_str(), u8"³", bestTransferResult[minTransfers - 1], u8"߳վ");
+        if (bestTransferResult[minTransfers - 1] == ds::WALK_LINE)
+            LOG("[Info] %s: %s%s\n", u8"յվ", string2UTF8(g_graph->vexAt(route[routeLen - 1]).name).c_str(), u8"е");
+        else
+            LOG("[Info] %s: %s%s%d%s\n", u8"յվ", string2UTF8(g_graph->vexAt(route[routeLen - 1]).name).c_str(), u8"³", bestTransferResult[minTransfers - 1], u8"߳վ");
         LOG("[Info] %s%d%s\n", u8"û˷ܹ", minTransfers - 1, u8"");
     }
 
@@ -248,6 +248,19 @@ private:
     ds::Vector<int> transferAtResult;
     ds::Vector<int> bestTransferResult;
     ds::Vector<bool> isVexInRoute;
+    Dijkstra::RouteWorkspace routeWorkspace;
+    Dijkstra::ContractionHierarchy contractionHierarchies[2];  //indexed by isWeighted, built on first use
+    Dijkstra::CustomizableHierarchy customizableHierarchy;
+    bool isMetricStale{ true };
+    uint64_t preprocessedVersion{ UINT64_MAX };  //graph version the routers above belong to
+    Dijkstra::Landmarks landmarks[2];  //indexed by isWeighted, built on first use
+    Dijkstra::RouteTable routeTables[2];  //indexed by isWeighted, loaded from disk or rebuilt whenever the graph no longer matches
+    Dijkstra::RouteCache routeCache;  //finished routes and legs of recent queries, dropped whenever the graph version moves
+    Dijkstra::RouteWorker routeWorker;  //answers queries off the UI thread, keeps shortest path trees of recent origins
+    Dijkstra::RouteKey speculatedKey{ -1, -1, Dijkstra::Router::Dijkstra, false, 0, 0 };
+    uint64_t speculatedVersion{ 0 };
+    std::shared_ptr<Dijkstra::RouteQuery> speculativeQuery;  //started when the query on screen changed, lands in routeCache
+    std::shared_ptr<Dijkstra::RouteQuery> activeQuery;  //started by the button, polled every frame until its route can be shown
 
     //canvas specs
     ImVec2 canvasOrigin{ 0.f, 0.f }; //screen coordinate of the origin point in canvas
@@ -414,6 +427,9 @@ inline void Menu::renderControls()
         static int tmpStartStationIdx = 0;
         static int tmpTerminalStationIdx = 0;
         static bool minimalStations = true;
+        static int routerIdx = 0;
+        static const char* routerNames[] = { "Dijkstra", "A*", "Bidirectional", "Transfer aware", "Contraction hierarchy", "Customizable hierarchy", "ALT (landmarks)", "Route table" };
+        static int transferPenalty = 0;
         ImGui::PushFont(msyh);
         ImGui::PushItemWidth(200.f);
         ImGui::Text("Start station:");
@@ -441,24 +457,162 @@ inline void Menu::renderControls()
         if (ImGui::RadioButton("Minimal stations", minimalStations)) minimalStations = !minimalStations;
         ImGui::SameLine();
         if (ImGui::RadioButton("Minimal cost", !minimalStations))minimalStations = !minimalStations;
+        ImGui::SameLine();
+        ImGui::PushItemWidth(120.f);
+        ImGui::Combo("Router", &routerIdx, routerNames, IM_ARRAYSIZE(routerNames));
+        ImGui::PopItemWidth();
+        const bool isTransferAware = (Dijkstra::Router)routerIdx == Dijkstra::Router::TransferAware;
+        if (isTransferAware)
+        {
+            ImGui::PushItemWidth(120.f);
+            ImGui::InputInt("Transfer penalty", &transferPenalty);
+            ImGui::PopItemWidth();
+            ImGui::SameLine();
+            helpMarker("Cost added to every transfer. With 0, the route with the fewest transfers among the cheapest ones is chosen. Ignored lines are never boarded.");
+            if (transferPenalty < 0) transferPenalty = 0;
+        }
+        const Dijkstra::RouteKey routeKey{ startStationIdx, terminalStationIdx, (Dijkstra::Router)routerIdx, !minimalStations,
+            isTransferAware ? transferPenalty : 0, isTransferAware ? ignoredLineMask() : 0 };
+        //routers without preprocessing in the menu run on the worker, never inside the frame
+        //they also start speculatively as soon as the query changes, so a click usually finds the route in the cache
+        const bool isAsync = isTransferAware || routeKey.router == Dijkstra::Router::Dijkstra
+            || routeKey.router == Dijkstra::Router::AStar || routeKey.router == Dijkstra::Router::Bidirectional;
+        if (this->activeQuery == nullptr && startStationIdx >= 0 && terminalStationIdx >= 0
+            && !(routeKey == this->speculatedKey && this->speculatedVersion == g_graph->getVersion()))
+        {
+            this->speculatedKey = routeKey;
+            this->speculatedVersion = g_graph->getVersion();
+            this->speculativeQuery.reset();
+            if (!isAsync || this->routeCache.contains(routeKey, this->speculatedVersion))
+                this->routeWorker.cancel();  //whatever it is still working on is stale
+            else
+            {
+                this->speculativeQuery = this->routeWorker.submit(routeKey, this->speculatedVersion, g_graph->freeze());
+            }
+        }
+        if (this->speculativeQuery != nullptr && this->speculativeQuery->isFinished())
+        {
+            const Dijkstra::RouteQuery& query = *this->speculativeQuery;
+            if (query.status() == Dijkstra::QueryStatus::Done)
+                this->routeCache.insert(query.key(), query.version(), query.route().begin(), query.route().size(), query.legs());
+            this->speculativeQuery.reset();
+        }
         if (ImGui::Button(ICON_FA_SEARCH " Find best route."))
         {
-            if (this->route != nullptr) {
-                free(this->route);
-                this->route = nullptr;
+            clearRoute();
+            syncGraphVersion();
+            ds::Vector<Dijkstra::Leg> legs;
+            const bool isCached = this->routeCache.find(routeKey, g_graph->getVersion(), this->route, this->routeLen, legs);
+            const ds::CSRGraph& csr = g_graph->freeze();
+            if (isCached)
+                LOG("[Info] Route served from cache...\n");
+            else if (isAsync)  //picked up by a later frame, a speculative search of the same query is reused
+            {
+                if (this->activeQuery != nullptr && !(this->activeQuery->key() == routeKey && this->activeQuery->version() == g_graph->getVersion()))
+                    this->activeQuery->cancel();  //a second click on the same query keeps its search
+                this->activeQuery = this->routeWorker.submit(routeKey, g_graph->getVersion(), csr, Dijkstra::ROUTE_QUERY_DEADLINE_MS);
+                this->speculativeQuery.reset();
             }
-            int** mat = nullptr;
-            int size = g_graph->asMat(mat, !minimalStations);
-            this->routeLen = Dijkstra::Helper::calculate((const int**)mat, size, startStationIdx, terminalStationIdx, this->route);
-            for (int i = 0; i < size; i++) free(mat[i]);
-            free(mat);
-            LOG("[Info] Search strategy: %s\n", minimalStations ? "Minimal transfer stations" : "Minimal cost");
-            this->isVexInRoute.clear();
-            this->isVexInRoute.resize(g_graph->size() + 8, false);
-            for (int i = 0; i < this->routeLen; i++) {
-                this->isVexInRoute[route[i]] = true;
+            else if ((Dijkstra::Router)routerIdx == Dijkstra::Router::ContractionHierarchy)
+            {
+                Dijkstra::ContractionHierarchy& hierarchy = this->contractionHierarchies[!minimalStations];
+                if (!hierarchy.isBuilt() && hierarchy.build(csr, !minimalStations))
+                    LOG("[Info] Contraction hierarchy built with %d shortcuts...\n", hierarchy.shortcutCnt());
+                this->routeLen = hierarchy.calculate(startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
             }
-            printRoute();
+            else if ((Dijkstra::Router)routerIdx == Dijkstra::Router::ALT)
+            {
+                Dijkstra::Landmarks& landmarks = this->landmarks[!minimalStations];
+                if (!landmarks.isBuilt() && landmarks.build(csr, !minimalStations))
+                    LOG("[Info] %d landmarks selected...\n", landmarks.count());
+                this->routeLen = Dijkstra::Helper::calculateALT(csr, !minimalStations, landmarks, startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
+            }
+            else if ((Dijkstra::Router)routerIdx == Dijkstra::Router::RouteTable)
+            {
+                Dijkstra::RouteTable& table = this->routeTables[!minimalStations];
+                const char* tablePath = minimalStations ? "route_table_stations.bin" : "route_table_cost.bin";
+                if (!table.matches(csr, !minimalStations) && !table.load(tablePath, csr, !minimalStations))
+                {
+                    if (table.build(csr, !minimalStations))
+                    {
+                        LOG("[Info] Route table built, %d KB...\n", (int)(table.memoryBytes() / 1024));
+                        if (!table.save(tablePath)) LOG("[Error] Unable to save route table to %s...\n", tablePath);
+                    }
+                    else
+                        LOG("[Error] Network too large for a route table, falling back to Dijkstra...\n");
+                }
+                if (table.isBuilt())
+                    this->routeLen = table.calculate(startStationIdx, terminalStationIdx, this->route);
+                else
+                    this->routeLen = Dijkstra::Helper::calculate(csr, !minimalStations, startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
+            }
+            else if ((Dijkstra::Router)routerIdx == Dijkstra::Router::CustomizableHierarchy)
+            {
+                Dijkstra::CustomizableHierarchy& hierarchy = this->customizableHierarchy;
+                if (this->isMetricStale || !hierarchy.isCustomized() || hierarchy.isWeighted() != !minimalStations)
+                {
+                    int recomputed = hierarchy.customize(csr, !minimalStations);
+                    if (recomputed == -1 && hierarchy.build(csr))  //stations or arcs were added
+                    {
+                        LOG("[Info] Customizable hierarchy built with %d arcs...\n", hierarchy.arcCnt());
+                        recomputed = hierarchy.customize(csr, !minimalStations);
+                    }
+                    if (recomputed == -1)  //stays stale, the next query tries again
+                    {
+                        LOG("[Error] Unable to customize route metric, falling back to Dijkstra...\n");
+                        this->isMetricStale = true;
+                    }
+                    else
+                    {
+                        LOG("[Info] Route metric customized, %d arcs recomputed...\n", recomputed);
+                        this->isMetricStale = false;
+                    }
+                }
+                if (this->isMetricStale)
+                    this->routeLen = Dijkstra::Helper::findRoute(Dijkstra::Router::Dijkstra, csr, !minimalStations, startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
+                else
+                    this->routeLen = hierarchy.calculate(startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
+            }
+            else
+                this->routeLen = Dijkstra::Helper::findRoute((Dijkstra::Router)routerIdx, csr, !minimalStations, startStationIdx, terminalStationIdx, this->route, this->routeWorkspace);
+            if (isCached || !isAsync)
+            {
+                LOG("[Info] Search strategy: %s, router: %s\n", minimalStations ? "Minimal transfer stations" : "Minimal cost", routerNames[routerIdx]);
+                markRoute();
+                if (!isCached && Dijkstra::TransferRouter::assignLines(csr, this->route, this->routeLen, legs) == -1)
+                    LOG("[Error] Unexpected error occured while finding best transfer route...\n");
+                else
+                {
+                    if (!isCached) this->routeCache.insert(routeKey, g_graph->getVersion(), this->route, this->routeLen, legs);
+                    printRoute(legs);
+                }
+            }
+        }
+        if (this->activeQuery != nullptr && !this->activeQuery->isFinished())
+        {
+            ImGui::SameLine();
+            ImGui::ProgressBar(this->activeQuery->progress(), ImVec2(120.f, 0.f),
+                this->activeQuery->status() == Dijkstra::QueryStatus::Pending ? "Waiting..." : "Searching...");
+            ImGui::SameLine();
+            if (ImGui::Button(ICON_FA_TIMES " Cancel")) this->activeQuery->cancel();
+        }
+        else if (this->activeQuery != nullptr)
+        {
+            const Dijkstra::RouteQuery& query = *this->activeQuery;
+            if (query.status() == Dijkstra::QueryStatus::Done)
+            {
+                this->routeLen = query.route().size();
+                if (this->routeLen > 0) this->route = (int*)malloc(this->routeLen * sizeof(int));
+                if (this->route != nullptr) memcpy(this->route, query.route().begin(), this->routeLen * sizeof(int));
+                else this->routeLen = 0;
+                this->routeCache.insert(query.key(), query.version(), this->route, this->routeLen, query.legs());
+                LOG("[Info] Search strategy: %s, router: %s\n", query.key().isWeighted ? "Minimal cost" : "Minimal transfer stations", routerNames[(int)query.key().router]);
+                markRoute();
+                printRoute(query.legs());
+            }
+            else
+                LOG("[Info] Route search %s...\n", query.status() == Dijkstra::QueryStatus::TimedOut ? "timed out" : "cancelled");
+            this->activeQuery.reset();
         }
 
         ImGui::EndTabItem();
@@ -490,7 +644,8 @@ inline void Menu::renderControls()
         ImGui::ColorEdit4("##RouteColor", &routeColor.x, ImGuiColorEditFlags_AlphaBar);
         ImGui::SameLine(0.0f, ImGui::GetStyle().ItemInnerSpacing.x);
         ImGui::TextUnformatted("Route");
-        for (int i = 1; i <= g_graph->getTotalLines(); i++) {
+        const int totalLines = g_graph->getTotalLines();
+        for (int i = 1; i <= totalLines; i++) {
             char buf[32];
             sprintf_s(buf, "Line %d", i);
             char buf2[32];
@@ -703,12 +858,15 @@ inline void Menu::renderAddControls()
             {
                 LOG("[Error] Unable to add new line, station name duplicated...");
             }
-            else
+            else if (g_graph->insert(UTF82string(startStationName), { lineNums + 1 }, startStationLatitude, startStationLongitude, {}, {}))
             {
-                g_graph->insert(UTF82string(startStationName), { lineNums + 1 }, startStationLatitude, startStationLongitude, {}, {});
                 LOG("[Info] Line %d has been added, %s as start station...", lineNums + 1, startStationName);
                 updateTexts();
             }
+            else
+            {
+                LOG("[Error] Unable to add new line...");
+            }
         }
         ImGui::PopItemWidth();
         ImGui::EndChild();
@@ -944,15 +1102,14 @@ inline void Menu::renderGraph()
     counter += 3.5f;
     if (counter >= 2 * 255) counter = 1;
     float routeMarkerAlpha = ((counter > 255) ? 255 * 2 - counter : counter) / 255.f;
+    const ds::LineSet ignoredLines(ignoredLineMask());
     for (int i = 0; i < g_graph->size(); i++)
     {
-        auto vex = g_graph->vexAt(i);
-        bool shouldIgnore = true;
-        for (auto line : vex.lineNum) shouldIgnore &= isRailwayLineIgnored[line];
-        if (shouldIgnore) continue;
+        const auto& vex = g_graph->vexAt(i);
+        if ((vex.lineNum.mask & ~ignoredLines.mask) == 0) continue;  //every line of the station is ignored
         ImVec2 src((vex.coord_x - SH_LONGITUDE) * ZOOM(graphScale) + canvasOrigin.x, -(vex.coord_y - SH_LATITUDE) * ZOOM(graphScale) + canvasOrigin.y);
         if (!g_graph->isTransfer(i)) {
-            drawList->AddCircle(src, ZOOM(stationMarkRadius), ImGui::ColorConvertFloat4ToU32(railwayLineColors[vex.lineNum[0]]), 0, ZOOM(stationMarkThickness));
+            drawList->AddCircle(src, ZOOM(stationMarkRadius), ImGui::ColorConvertFloat4ToU32(railwayLineColors[vex.lineNum.front()]), 0, ZOOM(stationMarkThickness));
         }
         else {
             drawList->AddCircle(src, ZOOM(transferStationMarkRadius), ImGui::ColorConvertFloat4ToU32(transferStationColor), 0, ZOOM(stationMarkThickness));
@@ -969,7 +1126,7 @@ inline void Menu::renderGraph()
         for (auto arc = vex.first; arc != nullptr; arc = arc->next)
         {
             if (arc->adjVex < 0) continue;
-            auto adjVex = g_graph->vexAt(arc->adjVex);
+            const auto& adjVex = g_graph->vexAt(arc->adjVex);
             ImVec2 dst((adjVex.coord_x - SH_LONGITUDE) * ZOOM(graphScale) + canvasOrigin.x, -(adjVex.coord_y - SH_LATITUDE) * ZOOM(graphScale) + canvasOrigin.y);
             ImVec4 lineColor(NULL, NULL, NULL, NULL);
             bool isSrcInRoute = false;
@@ -981,7 +1138,7 @@ inline void Menu::renderGraph()
             float modifierAngle = arc->lineNum.size() > 1 ? 0.25f : 0.f;
             for (auto lineNum : arc->lineNum)
             {
-                if (this->isRailwayLineIgnored[lineNum] == true) continue;
+                if (ignoredLines.contains(lineNum)) continue;
                 lineColor = shouldDrawRoute && isSrcInRoute && isDstInRoute ? routeColor : railwayLineColors[lineNum];
                 lineColor.w = (shouldDrawRoute && isSrcInRoute && isDstInRoute && shouldRouteBlink) ? routeMarkerAlpha : lineColor.w;
                 float lineWeight = shouldDrawRoute && isSrcInRoute && isDstInRoute ? 2.f : 1.5f;
@@ -1071,23 +1228,26 @@ inline void Menu::updateTexts()
     ZeroMemory(textStations, sizeof(const char**) * totalLines);
     ZeroMemory(textStationsCnts, sizeof(int) * totalLines);
 
-    for (int i = 0; i < bufferSize; i++)
+    //stations in riding order, a station shared by several branches is listed once
+    const ds::LineNetwork& network = g_graph->getLineNetwork();
+    for (int i = 0; i < totalLines; i++)
     {
-        auto vex = g_graph->vexAt(i);
-        auto str = string2UTF8(vex.name);
-        auto size = str.size() + 1;
-
-        for (int j = 0; j < vex.lineNum.size(); j++) {
-            uint32_t lineNum = vex.lineNum[j];
-            textStations[lineNum - 1] = (const char**)realloc(textStations[lineNum - 1], (textStationsCnts[lineNum - 1] + 1) * sizeof(const char*));
-            textStations[lineNum - 1][textStationsCnts[lineNum - 1]] = nullptr;
-            auto ptr = textStations[lineNum - 1][textStationsCnts[lineNum - 1]];
+        const ds::Line& line = network.lineAt(i + 1);
+        for (int stop = 0; stop < line.stopCnt(); stop++)
+        {
+            if (network.stopOf(i + 1, line.stationAt(stop)) != stop) continue;
+            auto str = string2UTF8(g_graph->vexAt(line.stationAt(stop)).name);
+            auto size = str.size() + 1;
+
+            textStations[i] = (const char**)realloc(textStations[i], (textStationsCnts[i] + 1) * sizeof(const char*));
+            textStations[i][textStationsCnts[i]] = nullptr;
+            auto ptr = textStations[i][textStationsCnts[i]];
             ptr = (const char*)realloc((void*)ptr, sizeof(char) * size);
             if (ptr == nullptr) return;
-            textStations[lineNum - 1][textStationsCnts[lineNum - 1]] = ptr;
+            textStations[i][textStationsCnts[i]] = ptr;
             memset((void*)ptr, 0, size);
             memcpy_s((void*)ptr, size, str.c_str(), size);
-            textStationsCnts[lineNum - 1]++;
+            textStationsCnts[i]++;
         }
     }
 
@@ -1108,7 +1268,9 @@ inline void Menu::updateTexts()
     {
         char buffer[256];
         memset(buffer, 0, sizeof(buffer));
-        sprintf_s(buffer, "%d", i + 1);
+        const std::string& name = g_graph->lineAt(i + 1).name;
+        if (name.empty()) sprintf_s(buffer, "%d", i + 1);
+        else sprintf_s(buffer, "%s", name.c_str());
         auto str = string2UTF8(buffer);
         const int size = str.size() + 1;
         textLines[i] = (const char*)realloc((void*)textLines[i], size * sizeof(const char));
@@ -2,107 +2,143 @@
 
 #include <iostream>
 
-#define LCHILD(x) 2 * x + 1
-#define RCHILD(x) 2 * x + 2
-#define PARENT(x) (x - 1) / 2
-
 namespace ds
 {
-    template<class T>
-    class MinHeap {
+    //indexed 4-ary min heap over ids in [0, n), every id is in the heap at most once
+    //insert() on an id already in the heap only ever lowers its cost (decrease-key), so the heap never holds more than n entries
+    template<class K>
+    class IndexedMinHeap {
     public:
-        MinHeap() = default;
-        MinHeap(const T* arr, const size_t size) { build(arr, size); };
-        ~MinHeap() { destroy(); };
+        struct Entry
+        {
+            int idx;
+            K cost;
+        };
+
+        IndexedMinHeap() = default;
+        ~IndexedMinHeap() { destroy(); };
 
-        void build(const T* arr, const size_t size)
+        IndexedMinHeap(IndexedMinHeap&&) = delete;
+        IndexedMinHeap(const IndexedMinHeap&) = delete;
+        IndexedMinHeap& operator=(const IndexedMinHeap&) = delete;
+
+        //empties the heap and makes room for ids in [0, idCnt), only the entries still queued are touched
+        bool reset(const int idCnt)
         {
-            int i = NULL;
-
-            // Insertion into the heap without violating the shape property
-            for (i = 0; i < size; i++) {
-                if (this->size) {
-                    this->elem = (T*)realloc((void*)this->elem, (this->size + 1) * sizeof(T));
-                }
-                else {
-                    this->elem = (T*)malloc(sizeof(T));
-                }
-                this->elem[(this->size)++] = arr[i];
-            }
+            for (int i = 0; i < this->size; i++) this->pos[this->elem[i].idx] = -1;
+            this->size = 0;
+            return reserve(idCnt);
+        }
 
-            // Making sure that heap property is also satisfied
-            for (i = (this->size - 1) / 2; i >= 0; i--) {
-                heapify(i);
-            }
+        bool reserve(const int idCnt)
+        {
+            if (idCnt <= this->capacity) return true;
+            int newCapacity = this->capacity ? this->capacity : 16;
+            while (newCapacity < idCnt) newCapacity *= 2;
+            Entry* newElem = (Entry*)realloc(this->elem, newCapacity * sizeof(Entry));
+            if (newElem != nullptr) this->elem = newElem;
+            int* newPos = (int*)realloc(this->pos, newCapacity * sizeof(int));
+            if (newPos != nullptr) this->pos = newPos;
+            if (newElem == nullptr || newPos == nullptr) return false;
+            memset(this->pos + this->capacity, -1, (newCapacity - this->capacity) * sizeof(int));
+            this->capacity = newCapacity;
+            return true;
         }
 
-        void insert(const T data)
+        inline bool contains(const int idx) const
         {
-            if (this->size) {
-                this->elem = (T*)realloc(this->elem, (this->size + 1) * sizeof(T));
-            }
-            else {
-                this->elem = (T*)malloc(sizeof(T));
-            }
+            return this->pos[idx] != -1;
+        }
 
-            int i = (this->size)++;
-            while (i && data < this->elem[PARENT(i)]) {
-                this->elem[i] = this->elem[PARENT(i)];
-                i = PARENT(i);
+        //inserts idx, or lowers its cost if it is already queued with a higher one
+        //returns false only if room for idx couldn't be made, never after reset() covered it
+        bool insert(const int idx, const K cost)
+        {
+            if (idx >= this->capacity && !reserve(idx + 1)) return false;
+            int i = this->pos[idx];
+            if (i == -1) {
+                i = this->size++;
             }
+            else if (!(cost < this->elem[i].cost)) return true;
+            siftUp(i, { idx, cost });
+            return true;
+        }
 
-            if(this->elem != nullptr)
-                this->elem[i] = data;
+        void decreaseKey(const int idx, const K cost)
+        {
+            insert(idx, cost);
         }
 
         void pop()
         {
-            if (this->size) {
-                this->elem[0] = this->elem[--(this->size)];
-                this->elem = (T*)realloc(this->elem, this->size * sizeof(T));
-                heapify(0);
-            }
-            else {
-                free(this->elem);
-            }
+            if (this->size == 0) return;
+            this->pos[this->elem[0].idx] = -1;
+            if (--this->size > 0) siftDown(0, this->elem[this->size]);
         }
 
-        bool empty()
+        bool empty() const
         {
             return this->size == 0;
         }
 
-        T front()
+        Entry front() const
         {
             return this->elem[0];
         }
 
+        int count() const
+        {
+            return this->size;
+        }
+
         void destroy() {
             free(this->elem);
+            free(this->pos);
+            this->elem = nullptr;
+            this->pos = nullptr;
+            this->size = this->capacity = 0;
         }
 
     private:
-        inline void swap(T* e1, T* e2)
+        static constexpr int ARITY = 4;
+
+        inline void place(const int i, const Entry& e)
         {
-            T tmp = *e1;
-            *e1 = *e2;
-            *e2 = tmp;
+            this->elem[i] = e;
+            this->pos[e.idx] = i;
         }
 
-        inline void heapify(int i) {
-            int smallest = (LCHILD(i) < this->size && this->elem[LCHILD(i)] < this->elem[i]) ? LCHILD(i) : i;
-            if (RCHILD(i) < this->size && this->elem[RCHILD(i)] < this->elem[smallest])
-            {
-                smallest = RCHILD(i);
+        inline void siftUp(int i, const Entry e)
+        {
+            while (i > 0) {
+                const int parent = (i - 1) / ARITY;
+                if (!(e.cost < this->elem[parent].cost)) break;
+                place(i, this->elem[parent]);
+                i = parent;
             }
-            if (smallest != i) {
-                swap(&this->elem[i], &this->elem[smallest]);
-                heapify(smallest);
+            place(i, e);
+        }
+
+        inline void siftDown(int i, const Entry e)
+        {
+            while (true) {
+                const int first = i * ARITY + 1;
+                if (first >= this->size) break;
+                const int last = first + ARITY < this->size ? first + ARITY : this->size;
+                int smallest = first;
+                for (int c = first + 1; c < last; c++)
+                    if (this->elem[c].cost < this->elem[smallest].cost) smallest = c;
+                if (!(this->elem[smallest].cost < e.cost)) break;
+                place(i, this->elem[smallest]);
+                i = smallest;
             }
+            place(i, e);
         }
 
     private:
-        size_t size;
-        T* elem;
+        Entry* elem{ nullptr };
+        int* pos{ nullptr };  //slot of every id in elem, -1 if not queued
+        int size{ 0 };
+        int capacity{ 0 };
     };
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include "Vector.hpp"
+#include "HashMap.hpp"
+#include "TransferRouter.hpp"
+#include "Dijkstra.hpp"
+
+namespace Dijkstra
+{
+	constexpr int ROUTE_CACHE_DEFAULT_CAPACITY = 256;
+
+	//everything a route depends on besides the graph itself
+	struct RouteKey
+	{
+		int origin;
+		int dst;
+		Router router;
+		bool isWeighted;
+		int transferPenalty;  //0 unless the router is transfer aware
+		uint64_t ignoredLines;
+
+		bool operator == (const RouteKey& key) const {
+			return this->origin == key.origin && this->dst == key.dst && this->router == key.router && this->isWeighted == key.isWeighted
+				&& this->transferPenalty == key.transferPenalty && this->ignoredLines == key.ignoredLines;
+		}
+
+		bool operator != (const RouteKey& key) const {
+			return !(*this == key);
+		}
+	};
+
+	struct RouteKeyHash
+	{
+		size_t operator()(const RouteKey& key) const {
+			uint64_t hash = 14695981039346656037ull;
+			const uint64_t fields[] = { (uint32_t)key.origin, (uint32_t)key.dst, (uint32_t)key.router, key.isWeighted, (uint32_t)key.transferPenalty, key.ignoredLines };
+			for (const uint64_t field : fields)
+			{
+				hash ^= field;
+				hash *= 1099511628211ull;
+			}
+			return (size_t)(hash ^ (hash >> 32));
+		}
+	};
+
+	//bounded cache of finished routes together with their legs, evicted in CLOCK order (second chance LRU)
+	//the cache is bound to one graph version, the first lookup or insert with a newer version drops every entry
+	//routes that can't be found are cached too, with a length of 0
+	class RouteCache
+	{
+	public:
+		explicit RouteCache(const int capacity = ROUTE_CACHE_DEFAULT_CAPACITY) : slotCnt(capacity > 0 ? capacity : 1)
+		{
+			this->slots = new Slot[this->slotCnt];
+		}
+
+		~RouteCache()
+		{
+			delete[] this->slots;
+		}
+
+		RouteCache(RouteCache&&) = delete;
+		RouteCache(const RouteCache&) = delete;
+		RouteCache& operator =(const RouteCache&) = delete;
+
+		//on a hit the route is copied out with the contract of Helper::calculate (malloc'd if route is nullptr)
+		bool find(const RouteKey& key, const uint64_t version, int*& route, int& routeLen, ds::Vector<Leg>& legs)
+		{
+			int slot = -1;
+			if (!sync(version) || !this->slotOf.find(key, slot))
+			{
+				this->misses++;
+				return false;
+			}
+			const Slot& entry = this->slots[slot];
+			if (entry.route.size() > 0)
+			{
+				if (route == nullptr)
+					route = (int*)malloc(entry.route.size() * sizeof(int));
+				if (route == nullptr) return false;
+				memcpy(route, entry.route.begin(), entry.route.size() * sizeof(int));
+			}
+			routeLen = entry.route.size();
+			legs = entry.legs;
+			this->slots[slot].isReferenced = true;
+			this->hits++;
+			return true;
+		}
+
+		//routes computed on an older version than the cache holds are ignored
+		void insert(const RouteKey& key, const uint64_t version, const int* route, const int routeLen, const ds::Vector<Leg>& legs)
+		{
+			if (!sync(version)) return;
+			int slot = -1;
+			if (!this->slotOf.find(key, slot))
+			{
+				slot = evict();
+				this->slots[slot].key = key;
+				this->slots[slot].isUsed = true;
+				this->slotOf.insert(key, slot);
+				this->used++;
+			}
+			Slot& entry = this->slots[slot];
+			entry.route.resize(routeLen > 0 ? routeLen : 0);
+			if (routeLen > 0) memcpy(entry.route.begin(), route, routeLen * sizeof(int));
+			entry.legs = legs;
+			entry.isReferenced = true;
+		}
+
+		inline bool contains(const RouteKey& key, const uint64_t version) const
+		{
+			int slot = -1;
+			return version == this->version && this->slotOf.find(key, slot);
+		}
+
+		void clear()
+		{
+			for (int k = 0; k < this->slotCnt; k++)
+			{
+				if (!this->slots[k].isUsed) continue;
+				this->slots[k].isUsed = false;
+				this->slots[k].isReferenced = false;
+				this->slots[k].route.clear();
+				this->slots[k].legs.clear();
+			}
+			this->slotOf.clear();
+			this->used = 0;
+			this->hand = 0;
+		}
+
+		inline int size() const {
+			return this->used;
+		}
+
+		inline int capacity() const {
+			return this->slotCnt;
+		}
+
+		inline int hitCnt() const {
+			return this->hits;
+		}
+
+		inline int missCnt() const {
+			return this->misses;
+		}
+
+	private:
+		struct Slot
+		{
+			RouteKey key{};
+			bool isUsed{ false };
+			bool isReferenced{ false };  //hit since the clock hand last passed
+			ds::Vector<int> route;
+			ds::Vector<Leg> legs;
+		};
+
+		//moves the cache to a newer version, false if version is older than the cached one
+		inline bool sync(const uint64_t version)
+		{
+			if (version < this->version) return false;
+			if (version == this->version) return true;
+			clear();
+			this->version = version;
+			return true;
+		}
+
+		//a free slot, else the first slot the clock hand finds unreferenced, clearing reference bits on the way
+		int evict()
+		{
+			if (this->used < this->slotCnt)
+			{
+				while (this->slots[this->hand].isUsed) this->hand = (this->hand + 1) % this->slotCnt;
+				return this->hand;
+			}
+			while (this->slots[this->hand].isReferenced) {
+				this->slots[this->hand].isReferenced = false;
+				this->hand = (this->hand + 1) % this->slotCnt;
+			}
+			const int slot = this->hand;
+			this->hand = (this->hand + 1) % this->slotCnt;
+			this->slotOf.erase(this->slots[slot].key);
+			this->slots[slot].isUsed = false;
+			this->used--;
+			return slot;
+		}
+
+	private:
+		Slot* slots{ nullptr };
+		const int slotCnt;
+		int hand{ 0 };
+		int used{ 0 };
+		int hits{ 0 };
+		int misses{ 0 };
+		uint64_t version{ 0 };
+		ds::HashMap<RouteKey, int, RouteKeyHash> slotOf;
+	};
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "Search.hpp"
+
+namespace Dijkstra
+{
+	constexpr uint16_t ROUTE_TABLE_UNREACHABLE = 0xFFFF;
+	constexpr int ROUTE_TABLE_MAX_SIZE = 4096;  //about 48 MB at the limit, affordable even for a 32-bit build, as Vector doesn't survive a failed malloc
+	constexpr uint32_t ROUTE_TABLE_MAGIC = 0x54505341;  //"ASPT" in a little endian file
+	constexpr uint32_t ROUTE_TABLE_FORMAT = 1;
+
+	//all pairs table: every cost and the first station of every route, a query is a lookup plus one step per station
+	//costs are symmetric and kept as an upper triangle of uint16_t, next hops are a full uint16_t matrix,
+	//so networks up to ROUTE_TABLE_MAX_SIZE stations with route costs below 65535 fit, about 3 bytes per ordered pair
+	class RouteTable
+	{
+	public:
+		RouteTable() = default;
+		~RouteTable() { clear(); };
+
+		RouteTable(RouteTable&&) = delete;
+		RouteTable(const RouteTable&) = delete;
+		RouteTable& operator =(const RouteTable&) = delete;
+
+		//one search per station, spread over threadCnt threads (0 uses every hardware thread)
+		//returns false if the network or one of its route costs doesn't fit the table
+		bool build(const ds::CSRGraph& graph, const bool isWeighted, int threadCnt = 0)
+		{
+			clear();
+			const int size = graph.size();
+			if (size <= 0 || size > ROUTE_TABLE_MAX_SIZE) return false; //size check
+			if (threadCnt <= 0) threadCnt = std::thread::hardware_concurrency();
+			if (threadCnt <= 0) threadCnt = 1;
+			if (threadCnt > size) threadCnt = size;
+
+			this->vexCnt = size;
+			this->costs.resize(size * (size - 1) / 2);
+			this->nextHops.resize(size * size);
+			std::atomic<int> next{ 0 };
+			std::atomic<bool> isOverflow{ false };
+			auto work = [&]() {
+				RouteWorkspace ws;
+				ds::Vector<int> order;
+				order.resize(size);
+				for (int origin = next++; origin < size; origin = next++)
+					if (!fillRow(graph, isWeighted, origin, ws, order.begin())) isOverflow = true;
+			};
+			if (threadCnt == 1) work();
+			else
+			{
+				ds::Vector<std::thread*> threads;
+				for (int t = 0; t < threadCnt; t++) threads.push_back(new std::thread(work));
+				for (auto thread : threads)
+				{
+					thread->join();
+					delete thread;
+				}
+			}
+			if (isOverflow)
+			{
+				clear();
+				return false;
+			}
+			this->weighted = isWeighted;
+			this->fingerprint = fingerprintOf(graph, isWeighted);
+			return true;
+		}
+
+		inline bool isBuilt() const {
+			return this->vexCnt > 0;
+		}
+
+		inline bool isWeighted() const {
+			return this->weighted;
+		}
+
+		inline int size() const {
+			return this->vexCnt;
+		}
+
+		//whether the table was built from graph as it is now
+		inline bool matches(const ds::CSRGraph& graph, const bool isWeighted) const {
+			return isBuilt() && this->weighted == isWeighted && this->fingerprint == fingerprintOf(graph, isWeighted);
+		}
+
+		//cost of the cheapest route, INT_MAX if dst can't be reached or an idx is out of range
+		int distance(const int origin, const int dst) const
+		{
+			if (origin < 0 || origin >= this->vexCnt || dst < 0 || dst >= this->vexCnt) return INT_MAX; //idx check
+			if (origin == dst) return 0;
+			const uint16_t cost = this->costs[pairOf(origin, dst)];
+			return cost == ROUTE_TABLE_UNREACHABLE ? INT_MAX : cost;
+		}
+
+		//same contract as Helper::calculate, the route is walked through the next hop matrix
+		int calculate(const int origin, const int dst, int*& route) const
+		{
+			if (distance(origin, dst) == INT_MAX) return 0; //unreachable
+			int routeLen = 1;
+			for (int v = origin; v != dst; v = this->nextHops[v * this->vexCnt + dst]) routeLen++;
+			if (route == nullptr)
+				route = (int*)malloc(routeLen * sizeof(int));
+			if (route == nullptr) return 0;
+			int i = 0;
+			for (int v = origin; v != dst; v = this->nextHops[v * this->vexCnt + dst]) route[i++] = v;
+			route[i] = dst;
+			return routeLen;
+		}
+
+		inline size_t memoryBytes() const {
+			return (size_t)this->costs.size() * sizeof(uint16_t) + (size_t)this->nextHops.size() * sizeof(uint16_t);  //size_in_bytes() overflows int near the size limit
+		}
+
+		//binary dump: header, costs, next hops
+		bool save(const char* path) const
+		{
+			if (!isBuilt()) return false;
+			FILE* file = nullptr;
+			if (fopen_s(&file, path, "wb") != 0 || file == nullptr) return false;
+			const uint32_t header[] = { ROUTE_TABLE_MAGIC, ROUTE_TABLE_FORMAT, (uint32_t)this->vexCnt, (uint32_t)this->weighted };
+			bool isWritten = fwrite(header, sizeof(header), 1, file) == 1
+				&& fwrite(&this->fingerprint, sizeof(this->fingerprint), 1, file) == 1
+				&& fwrite(this->costs.begin(), sizeof(uint16_t), this->costs.size(), file) == this->costs.size()
+				&& fwrite(this->nextHops.begin(), sizeof(uint16_t), this->nextHops.size(), file) == this->nextHops.size();
+			fclose(file);
+			return isWritten;
+		}
+
+		//loads a table saved by save(), rejected unless it was built from graph as it is now with the same metric
+		bool load(const char* path, const ds::CSRGraph& graph, const bool isWeighted)
+		{
+			clear();
+			FILE* file = nullptr;
+			if (fopen_s(&file, path, "rb") != 0 || file == nullptr) return false;
+			uint32_t header[4] = { 0 };
+			uint64_t savedFingerprint = 0;
+			bool isRead = fread(header, sizeof(header), 1, file) == 1 && fread(&savedFingerprint, sizeof(savedFingerprint), 1, file) == 1;
+			const int size = (int)header[2];
+			isRead = isRead && header[0] == ROUTE_TABLE_MAGIC && header[1] == ROUTE_TABLE_FORMAT
+				&& size == graph.size() && size > 0 && size <= ROUTE_TABLE_MAX_SIZE
+				&& (header[3] != 0) == isWeighted && savedFingerprint == fingerprintOf(graph, isWeighted);
+			if (isRead)
+			{
+				this->costs.resize(size * (size - 1) / 2);
+				this->nextHops.resize(size * size);
+				isRead = fread(this->costs.begin(), sizeof(uint16_t), this->costs.size(), file) == this->costs.size()
+					&& fread(this->nextHops.begin(), sizeof(uint16_t), this->nextHops.size(), file) == this->nextHops.size();
+			}
+			fclose(file);
+			if (!isRead)
+			{
+				clear();
+				return false;
+			}
+			this->vexCnt = size;
+			this->weighted = isWeighted;
+			this->fingerprint = savedFingerprint;
+			return true;
+		}
+
+		void clear()
+		{
+			this->vexCnt = 0;
+			this->weighted = false;
+			this->fingerprint = 0;
+			this->costs.clear();
+			this->nextHops.clear();
+		}
+
+		//FNV-1a over the arcs and, for the weighted metric, their costs
+		static uint64_t fingerprintOf(const ds::CSRGraph& graph, const bool isWeighted)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			auto mix = [&hash](const int value) {
+				for (int b = 0; b < 4; b++)
+				{
+					hash ^= (uint8_t)(value >> (b * 8));
+					hash *= 1099511628211ull;
+				}
+			};
+			mix(graph.size());
+			for (int i = 0; i < graph.size(); i++)
+			{
+				for (int e = graph.begin(i); e < graph.end(i); e++)
+				{
+					mix(graph.targets[e]);
+					mix(isWeighted ? graph.costs[e] : graph.costs[e] > 0);
+				}
+				mix(-1);
+			}
+			return hash;
+		}
+
+	private:
+		//slot of the unordered pair (i, j), i != j, in the upper triangle
+		inline int pairOf(int i, int j) const
+		{
+			if (i > j)
+			{
+				const int t = i;
+				i = j;
+				j = t;
+			}
+			return (int)((int64_t)i * (2 * this->vexCnt - i - 1) / 2) + (j - i - 1);
+		}
+
+		//one to all search from origin, writes the costs to higher stations and origin's row of next hops
+		//returns false if a cost doesn't fit into uint16_t or the search ran out of memory
+		bool fillRow(const ds::CSRGraph& graph, const bool isWeighted, const int origin, RouteWorkspace& ws, int* order)
+		{
+			const int size = this->vexCnt;
+			int settled = 0;
+			const bool isSearched = Search::run(graph, isWeighted, origin, -1, ws, [&](const int idx, const int) {
+				order[settled++] = idx;
+				return Visit::Expand;
+			});
+			if (!isSearched) return false;
+
+			uint16_t* row = &this->nextHops[origin * size];
+			for (int v = 0; v < size; v++) row[v] = ROUTE_TABLE_UNREACHABLE;
+			row[origin] = (uint16_t)origin;
+			for (int k = 1; k < settled; k++)  //parents are settled first, so the first hop is inherited down the tree
+			{
+				const int v = order[k];
+				const int parent = ws.parentOf(v);
+				row[v] = parent == origin ? (uint16_t)v : row[parent];
+			}
+			bool isFit = true;
+			for (int v = origin + 1; v < size; v++)  //each row owns the pairs with higher stations, so threads never share a slot
+			{
+				const int dis = ws.dis(v);
+				if (dis != INT_MAX && dis >= ROUTE_TABLE_UNREACHABLE) isFit = false;
+				this->costs[pairOf(origin, v)] = dis == INT_MAX || !isFit ? ROUTE_TABLE_UNREACHABLE : (uint16_t)dis;
+			}
+			return isFit;
+		}
+
+	private:
+		int vexCnt{ 0 };
+		bool weighted{ false };
+		uint64_t fingerprint{ 0 };
+		ds::Vector<uint16_t> costs;  //pair (i, j) with i < j sits at i * (2n - i - 1) / 2 + j - i - 1
+		ds::Vector<uint16_t> nextHops;  //first station after i on the route from i to j is nextHops[i * n + j]
+	};
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "TransferRouter.hpp"
+#include "Dijkstra.hpp"
+#include "RouteCache.hpp"
+#include "ShortestPathTree.hpp"
+
+namespace Dijkstra
+{
+	constexpr int ROUTE_QUERY_DEADLINE_MS = 10000;  //queries the user waits for give up after this long
+
+	enum class QueryStatus
+	{
+		Pending,  //waiting for the worker
+		Running,
+		Done,  //route() and legs() hold the answer, an empty route if dst can't be reached
+		Cancelled,
+		TimedOut,
+	};
+
+	//handle of a query handed to a RouteWorker, shared by the worker and the caller, who polls it until it is finished
+	class RouteQuery
+	{
+	public:
+		RouteQuery(const RouteKey& key, const uint64_t version, const ds::CSRGraph& graph, const int deadlineMs)
+			: queryKey(key), graphVersion(version), graph(graph), spaceSize(key.router == Router::TransferAware ? graph.stateCnt() : graph.size())
+		{
+			this->interrupt.tightenDeadline(deadlineMs);
+		}
+
+		RouteQuery(RouteQuery&&) = delete;
+		RouteQuery(const RouteQuery&) = delete;
+		RouteQuery& operator =(const RouteQuery&) = delete;
+
+		inline QueryStatus status() const {
+			const QueryStatus status = this->state.load(std::memory_order_acquire);
+			return status == QueryStatus::Pending && this->interrupt.isCancelled ? QueryStatus::Cancelled : status;
+		}
+
+		inline bool isFinished() const {
+			return status() >= QueryStatus::Done;
+		}
+
+		//share of the search space settled so far, only a hint as searches usually stop well before settling everything
+		inline float progress() const {
+			if (this->state.load(std::memory_order_acquire) == QueryStatus::Done) return 1.f;
+			const float settled = (float)this->interrupt.settled.load(std::memory_order_relaxed) / (this->spaceSize > 0 ? this->spaceSize : 1);
+			return settled < 1.f ? settled : 1.f;
+		}
+
+		//the worker stops at its next check, the query then finishes as Cancelled
+		inline void cancel() {
+			this->interrupt.isCancelled = true;
+		}
+
+		inline const RouteKey& key() const {
+			return this->queryKey;
+		}
+
+		inline uint64_t version() const {
+			return this->graphVersion;
+		}
+
+		//only meaningful once status() is Done
+		inline const ds::Vector<int>& route() const {
+			return this->stations;
+		}
+
+		inline const ds::Vector<Leg>& legs() const {
+			return this->rideLegs;
+		}
+
+	private:
+		friend class RouteWorker;
+
+		const RouteKey queryKey;
+		const uint64_t graphVersion;
+		ds::CSRGraph graph;  //snapshot the query runs on, released once it is finished
+		const int spaceSize;  //vertexes, or (station, line) states, the search may settle
+		Interrupt interrupt;
+		std::atomic<QueryStatus> state{ QueryStatus::Pending };
+		ds::Vector<int> stations;
+		ds::Vector<Leg> rideLegs;
+	};
+
+	//one background thread answering the latest query handed to it, off the UI thread
+	//a submit cancels the query before it, whether it is still waiting or already running, searches check for that cooperatively
+	//plain Dijkstra queries go through shortest path trees kept by the worker, so later queries from the same origin are instant
+	class RouteWorker
+	{
+	public:
+		RouteWorker()
+		{
+			this->thread = new std::thread(&RouteWorker::run, this);
+		}
+
+		~RouteWorker()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->isStopping = true;
+				if (this->latest != nullptr) this->latest->cancel();
+			}
+			this->wakeCv.notify_one();
+			this->thread->join();
+			delete this->thread;
+		}
+
+		RouteWorker(RouteWorker&&) = delete;
+		RouteWorker(const RouteWorker&) = delete;
+		RouteWorker& operator =(const RouteWorker&) = delete;
+
+		//queues a query over a copy of graph, which was taken at the given SubwayGraph version, deadlineMs 0 never times out
+		//the same query on the same version, if it is still waiting, running or done and wasn't cancelled, is not restarted: its handle is returned instead,
+		//with its deadline moved up to deadlineMs from now if that is earlier, so a speculative query picked up by a click still times out
+		std::shared_ptr<RouteQuery> submit(const RouteKey& key, const uint64_t version, const ds::CSRGraph& graph, const int deadlineMs = 0)
+		{
+			std::shared_ptr<RouteQuery> query;
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				if (this->latest != nullptr && this->latest->key() == key && this->latest->version() == version
+					&& this->latest->status() <= QueryStatus::Done && !this->latest->interrupt.isCancelled)  //a cancelled search may still be running
+				{
+					this->latest->interrupt.tightenDeadline(deadlineMs);
+					return this->latest;
+				}
+				if (this->latest != nullptr) this->latest->cancel();
+				query = std::make_shared<RouteQuery>(key, version, graph, deadlineMs);
+				this->latest = query;
+				this->hasJob = true;
+			}
+			this->wakeCv.notify_one();
+			return query;
+		}
+
+		//cancels the latest query, and with it every query handed in before
+		void cancel()
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			if (this->latest != nullptr) this->latest->cancel();
+		}
+
+	private:
+		void run()
+		{
+			while (true) {
+				std::shared_ptr<RouteQuery> query;
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->wakeCv.wait(lock, [this]() { return this->isStopping || this->hasJob; });
+					if (this->isStopping) return;
+					query = this->latest;
+					this->hasJob = false;
+				}
+				if (query->interrupt.isCancelled)
+				{
+					finish(*query, QueryStatus::Cancelled);
+					continue;
+				}
+
+				const RouteKey& key = query->queryKey;
+				const ds::CSRGraph& graph = query->graph;
+				query->state.store(QueryStatus::Running, std::memory_order_release);
+				this->ws.attach(&query->interrupt);
+				int* route = nullptr;
+				int routeLen = 0;
+				if (key.router == Router::TransferAware)
+					routeLen = TransferRouter::calculate(graph, key.isWeighted, key.origin, key.dst, key.transferPenalty, route, query->rideLegs, this->ws, key.ignoredLines);
+				else
+				{
+					if (key.router == Router::Dijkstra)
+						routeLen = this->trees.calculate(graph, key.isWeighted, query->graphVersion, key.origin, key.dst, route, this->ws);
+					else
+						routeLen = Helper::findRoute(key.router, graph, key.isWeighted, key.origin, key.dst, route, this->ws);
+					TransferRouter::assignLines(graph, route, routeLen, query->rideLegs);
+				}
+				const bool isInterrupted = this->ws.isInterrupted();
+				this->ws.attach(nullptr);
+
+				if (!isInterrupted)
+				{
+					query->stations.resize(routeLen > 0 ? routeLen : 0);
+					if (routeLen > 0) memcpy(query->stations.begin(), route, routeLen * sizeof(int));
+				}
+				free(route);
+				finish(*query, !isInterrupted ? QueryStatus::Done : query->interrupt.isCancelled ? QueryStatus::Cancelled : QueryStatus::TimedOut);
+			}
+		}
+
+		static void finish(RouteQuery& query, const QueryStatus status)
+		{
+			query.graph.clear();
+			if (status != QueryStatus::Done) query.rideLegs.clear();
+			query.state.store(status, std::memory_order_release);
+		}
+
+	private:
+		std::thread* thread{ nullptr };
+		std::mutex mutex;
+		std::condition_variable wakeCv;
+		bool isStopping{ false };
+		bool hasJob{ false };
+		std::shared_ptr<RouteQuery> latest;  //newest query handed in, guarded by mutex
+		RouteWorkspace ws;  //only touched by the worker thread
+		ShortestPathTrees trees;
+	};
+}
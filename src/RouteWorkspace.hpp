@@ -0,0 +1,224 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include "BucketQueue.hpp"
+#include "MinHeap.hpp"
+
+namespace Dijkstra
+{
+	constexpr int INTERRUPT_CHECK_INTERVAL = 256;  //settled vertexes between two looks at the cancel flag and the clock
+
+	//cooperative stop request shared by a running query and whoever waits for it
+	struct Interrupt
+	{
+		std::atomic<bool> isCancelled{ false };
+		std::atomic<int> settled{ 0 };  //vertexes settled so far, only updated every INTERRUPT_CHECK_INTERVAL
+		std::atomic<int64_t> deadline{ 0 };  //steady_clock ticks to give up at, 0 never times out
+
+		//moves the deadline to deadlineMs from now unless it is already earlier, safe while a search polls it
+		void tightenDeadline(const int deadlineMs)
+		{
+			if (deadlineMs <= 0) return;
+			const int64_t ticks = (std::chrono::steady_clock::now() + std::chrono::milliseconds(deadlineMs)).time_since_epoch().count();
+			int64_t current = this->deadline.load(std::memory_order_relaxed);
+			while ((current == 0 || ticks < current) && !this->deadline.compare_exchange_weak(current, ticks, std::memory_order_relaxed)) {}
+		}
+	};
+
+	//scratch state of a route query, keep one per thread and reuse it across queries
+	//every slot is stamped with the epoch of the query that wrote it, so reset() is O(1) instead of a malloc plus O(V) memset
+	class RouteWorkspace
+	{
+	public:
+		RouteWorkspace() = default;
+		~RouteWorkspace() { destroy(); };
+
+		RouteWorkspace(RouteWorkspace&&) = delete;
+		RouteWorkspace(const RouteWorkspace&) = delete;
+		RouteWorkspace& operator =(const RouteWorkspace&) = delete;
+
+		//prepares the workspace for a query over a graph with size vertexes
+		bool reset(const int size)
+		{
+			if (size > this->capacity && !grow(size)) return false;
+			if (++this->epoch == 0)  //stamps wrapped around, the only case that needs a full clear
+			{
+				memset(this->reachedStamp, 0, this->capacity * sizeof(uint32_t));
+				memset(this->settledStamp, 0, this->capacity * sizeof(uint32_t));
+				this->epoch = 1;
+			}
+			return true;
+		}
+
+		inline bool isReached(const int idx) const {
+			return this->reachedStamp[idx] == this->epoch;
+		}
+
+		inline bool isSettled(const int idx) const {
+			return this->settledStamp[idx] == this->epoch;
+		}
+
+		inline int dis(const int idx) const {
+			return isReached(idx) ? this->minDis[idx] : INT_MAX;
+		}
+
+		inline int parentOf(const int idx) const {
+			return isReached(idx) ? this->parent[idx] : -1;
+		}
+
+		inline void relax(const int idx, const int dis, const int parent) {
+			this->reachedStamp[idx] = this->epoch;
+			this->minDis[idx] = dis;
+			this->parent[idx] = parent;
+		}
+
+		//secondary cost used as a tie breaker by lexicographic searches
+		inline int secondaryOf(const int idx) const {
+			return isReached(idx) ? this->secondary[idx] : INT_MAX;
+		}
+
+		inline void relax(const int idx, const int dis, const int secondary, const int parent) {
+			relax(idx, dis, parent);
+			this->secondary[idx] = secondary;
+		}
+
+		inline void settle(const int idx) {
+			this->settledStamp[idx] = this->epoch;
+			progress(1);
+		}
+
+		//reports settled vertexes to the attached interrupt, settle() already counts itself
+		inline void progress(const int settledCnt) {
+			if (this->interrupt == nullptr) return;
+			this->uncounted += settledCnt;
+			if (this->uncounted >= INTERRUPT_CHECK_INTERVAL) pollInterrupt();
+		}
+
+		//the following queries stop early once interrupt is cancelled or past its deadline, nullptr detaches it
+		inline void attach(Interrupt* interrupt) {
+			this->interrupt = interrupt;
+			this->uncounted = 0;
+			this->isStopped = false;
+		}
+
+		//the attached interrupt fired, searches give up and report no route
+		inline bool isInterrupted() const {
+			return this->isStopped;
+		}
+
+		//predecessor array of the last query, only entries on a reached chain are meaningful
+		inline const int* parents() const {
+			return this->parent;
+		}
+
+		//fifo of vertexes for breadth first searches, holds at least as many slots as the last reset size
+		inline int* fifo() {
+			return this->queue;
+		}
+
+		//bucket queue kept across queries, used when arc costs are small integers
+		inline ds::BucketQueue& bucketQueue() {
+			return this->buckets;
+		}
+
+		//indexed heaps kept across queries, each holds every vertex at most once
+		//keyed by cost for Dijkstra, by cost plus lower bound for A*, and by (cost << 32 | transfers) for TransferRouter
+		inline ds::IndexedMinHeap<int>& costHeap() {
+			return this->costQueue;
+		}
+
+		inline ds::IndexedMinHeap<double>& boundHeap() {
+			return this->boundQueue;
+		}
+
+		inline ds::IndexedMinHeap<int64_t>& stateHeap() {
+			return this->stateQueue;
+		}
+
+		//second set of search state for searches that grow from both ends, allocated on first use
+		RouteWorkspace& backward()
+		{
+			if (this->reverse == nullptr) this->reverse = new RouteWorkspace();
+			return *this->reverse;
+		}
+
+		void destroy()
+		{
+			delete this->reverse;
+			this->reverse = nullptr;
+			this->buckets.destroy();
+			this->costQueue.destroy();
+			this->boundQueue.destroy();
+			this->stateQueue.destroy();
+			free(this->reachedStamp);
+			free(this->settledStamp);
+			free(this->minDis);
+			free(this->parent);
+			free(this->secondary);
+			free(this->queue);
+			this->queue = nullptr;
+			this->reachedStamp = this->settledStamp = nullptr;
+			this->minDis = this->parent = this->secondary = nullptr;
+			this->capacity = 0;
+			this->epoch = 0;
+		}
+
+	private:
+		void pollInterrupt()
+		{
+			this->interrupt->settled.fetch_add(this->uncounted, std::memory_order_relaxed);
+			this->uncounted = 0;
+			const int64_t deadline = this->interrupt->deadline.load(std::memory_order_relaxed);
+			if (this->interrupt->isCancelled.load(std::memory_order_relaxed)
+				|| (deadline != 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline))
+				this->isStopped = true;
+		}
+
+		bool grow(const int size)
+		{
+			int newCapacity = this->capacity ? this->capacity : 64;
+			while (newCapacity < size) newCapacity *= 2;
+
+			uint32_t* newReached = (uint32_t*)realloc(this->reachedStamp, newCapacity * sizeof(uint32_t));
+			if (newReached != nullptr) this->reachedStamp = newReached;
+			uint32_t* newSettled = (uint32_t*)realloc(this->settledStamp, newCapacity * sizeof(uint32_t));
+			if (newSettled != nullptr) this->settledStamp = newSettled;
+			int* newMinDis = (int*)realloc(this->minDis, newCapacity * sizeof(int));
+			if (newMinDis != nullptr) this->minDis = newMinDis;
+			int* newParent = (int*)realloc(this->parent, newCapacity * sizeof(int));
+			if (newParent != nullptr) this->parent = newParent;
+			int* newSecondary = (int*)realloc(this->secondary, newCapacity * sizeof(int));
+			if (newSecondary != nullptr) this->secondary = newSecondary;
+			int* newQueue = (int*)realloc(this->queue, newCapacity * sizeof(int));
+			if (newQueue != nullptr) this->queue = newQueue;
+			if (newReached == nullptr || newSettled == nullptr || newMinDis == nullptr || newParent == nullptr || newSecondary == nullptr || newQueue == nullptr) return false;
+
+			//new slots must never look stamped by the current epoch
+			memset(this->reachedStamp + this->capacity, 0, (newCapacity - this->capacity) * sizeof(uint32_t));
+			memset(this->settledStamp + this->capacity, 0, (newCapacity - this->capacity) * sizeof(uint32_t));
+			this->capacity = newCapacity;
+			return true;
+		}
+
+	private:
+		uint32_t* reachedStamp{ nullptr };
+		uint32_t* settledStamp{ nullptr };
+		int* minDis{ nullptr };
+		int* parent{ nullptr };
+		int* secondary{ nullptr };
+		int* queue{ nullptr };
+		int capacity{ 0 };
+		uint32_t epoch{ 0 };
+		RouteWorkspace* reverse{ nullptr };
+		ds::BucketQueue buckets;
+		ds::IndexedMinHeap<int> costQueue;
+		ds::IndexedMinHeap<double> boundQueue;
+		ds::IndexedMinHeap<int64_t> stateQueue;
+		Interrupt* interrupt{ nullptr };
+		int uncounted{ 0 };  //settled since the last poll of the interrupt
+		bool isStopped{ false };
+	};
+}
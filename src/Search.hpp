@@ -0,0 +1,153 @@
+#pragma once
+
+#include <iostream>
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+
+namespace Dijkstra
+{
+	constexpr int BUCKET_QUEUE_MAX_COST = 1024;  //largest arc cost for which Dial's bucket queue beats the binary heap
+	constexpr int BFS_BOTTOM_UP_MIN_SIZE = 4096;  //graphs from this size on use direction optimizing breadth first search
+	constexpr int BFS_BOTTOM_UP_ALPHA = 14;  //go bottom-up once the frontier holds more than 1/alpha of the unexplored arcs
+
+	//what a search does with the vertex it just settled
+	enum class Visit
+	{
+		Expand,  //relax its arcs
+		Prune,  //keep its cost but don't search past it
+		Stop,  //end the search
+	};
+
+	//one to one and one to all search over a CSRGraph, the single relax and settle loop behind the plain router and every preprocessing step
+	//hop counts go breadth first, otherwise a bucket queue is picked over the indexed heap when arc costs are small integers
+	class Search
+	{
+	private:
+		Search() = delete; //INCONSTRUCTIBLE
+		Search(Search&&) = delete;
+		Search(const Search&) = delete;
+		Search& operator =(const Search&) = delete;
+
+	public:
+		//settles vertexes from origin in cost order until dst is settled, dst -1 searches everything reachable
+		//onSettle(idx, cost) sees every settled vertex once and returns a Visit
+		//returns false if the search state couldn't be allocated, ws holds the costs and parents found otherwise
+		template<class OnSettle>
+		static bool run(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, RouteWorkspace& ws, OnSettle&& onSettle)
+		{
+			const int size = graph.size();
+			if (!isWeighted) return bfs(graph, origin, dst, ws, size >= BFS_BOTTOM_UP_MIN_SIZE, onSettle);
+			if (!ws.reset(size)) return false;
+			ws.relax(origin, 0, -1);
+			const int maxCost = graph.maxArcCost(isWeighted);
+			if (maxCost <= BUCKET_QUEUE_MAX_COST && ws.bucketQueue().reset(maxCost))
+				return dijkstra(graph, origin, dst, ws, ws.bucketQueue(), onSettle);
+			if (!ws.costHeap().reset(size)) return false;
+			return dijkstra(graph, origin, dst, ws, ws.costHeap(), onSettle);
+		}
+
+		static bool run(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, RouteWorkspace& ws)
+		{
+			return run(graph, isWeighted, origin, dst, ws, [](const int, const int) { return Visit::Expand; });
+		}
+
+		//breadth first search for the unweighted metric, a plain fifo frontier and no heap, same contract as run()
+		//when directionOptimizing is set, levels whose frontier touches a large share of the unexplored arcs are expanded bottom-up:
+		//every unreached vertex looks for a parent in the frontier instead of the frontier scanning all of its arcs
+		template<class OnSettle>
+		static bool bfs(const ds::CSRGraph& graph, const int origin, const int dst, RouteWorkspace& ws, const bool directionOptimizing, OnSettle&& onSettle)
+		{
+			const int size = graph.size();
+			if (!ws.reset(size)) return false;
+			ws.relax(origin, 0, -1);
+			int* queue = ws.fifo();
+			int head = 0;
+			int tail = 0;
+			queue[tail++] = origin;
+			int unexploredArcs = graph.arcCnt();
+			bool isPruned = false;  //bottom-up steps can't tell pruned parents apart, so they are off once anything is pruned
+			for (int level = 0; head < tail && !ws.isInterrupted(); level++)
+			{
+				const int levelEnd = tail;
+				int expandEnd = head;  //vertexes of this level to expand are moved to [head, expandEnd)
+				for (int k = head; k < levelEnd; k++)
+				{
+					const int u = queue[k];
+					ws.settle(u);
+					const Visit visit = onSettle(u, level);
+					if (visit == Visit::Stop || u == dst) return true; //point to point, dst is settled
+					if (visit == Visit::Prune) isPruned = true;
+					else queue[expandEnd++] = u;
+				}
+				int frontierArcs = 0;
+				for (int k = head; k < expandEnd; k++) frontierArcs += graph.end(queue[k]) - graph.begin(queue[k]);
+
+				if (directionOptimizing && !isPruned && frontierArcs * BFS_BOTTOM_UP_ALPHA > unexploredArcs)  //bottom-up step
+				{
+					for (int v = 0; v < size; v++)
+					{
+						if (ws.isReached(v)) continue;
+						for (int e = graph.begin(v); e < graph.end(v); e++)
+						{
+							const int u = graph.targets[e];
+							if (ws.isReached(u) && ws.dis(u) == level)
+							{
+								ws.relax(v, level + 1, u);
+								queue[tail++] = v;
+								break;
+							}
+						}
+					}
+				}
+				else  //top-down step
+				{
+					for (int k = head; k < expandEnd; k++)
+					{
+						const int u = queue[k];
+						for (int e = graph.begin(u); e < graph.end(u); e++)
+						{
+							const int v = graph.targets[e];
+							if (ws.isReached(v)) continue;
+							ws.relax(v, level + 1, u);
+							queue[tail++] = v;
+						}
+					}
+				}
+				unexploredArcs -= frontierArcs;
+				head = levelEnd;
+			}
+			return true;
+		}
+
+	private:
+		//Dijkstra main loop over the arc costs, works with any queue offering bool insert(idx, cost), front(), pop() and empty()
+		//returns false if the queue couldn't take an entry, the search is then incomplete and must not be trusted
+		template<class Queue, class OnSettle>
+		static bool dijkstra(const ds::CSRGraph& graph, const int origin, const int dst, RouteWorkspace& ws, Queue& queue, OnSettle& onSettle)
+		{
+			if (!queue.insert(origin, 0)) return false;
+			while (!queue.empty() && !ws.isInterrupted()) {
+				const auto curNode = queue.front();
+				queue.pop();
+				if (ws.isSettled(curNode.idx)) continue; //stale entry, only the bucket queue keeps them
+				ws.settle(curNode.idx);
+				const Visit visit = onSettle(curNode.idx, curNode.cost);
+				if (visit == Visit::Stop || curNode.idx == dst) break; //point to point, dst is settled
+				if (visit == Visit::Prune) continue;
+				for (int e = graph.begin(curNode.idx); e < graph.end(curNode.idx); e++)
+				{
+					const int i = graph.targets[e];
+					const int cost = graph.costs[e];
+					if (cost <= 0 || ws.isSettled(i)) continue;  //not connected or visited
+					const int dis = curNode.cost + cost;
+					if (dis < ws.dis(i))
+					{
+						ws.relax(i, dis, curNode.idx);
+						if (!queue.insert(i, dis)) return false;
+					}
+				}
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+#include "Search.hpp"
+
+namespace Dijkstra
+{
+	constexpr int SHORTEST_PATH_TREE_CNT = 4;  //recent origins whose trees are kept
+
+	//full shortest path trees of the most recent origins, one to all search runs once per origin and metric,
+	//every later query from that origin is a walk up the parents with no search at all
+	//trees are tagged with the graph version they were grown on and are regrown once it moves
+	class ShortestPathTrees
+	{
+	public:
+		ShortestPathTrees() = default;
+		~ShortestPathTrees() { clear(); };
+
+		ShortestPathTrees(ShortestPathTrees&&) = delete;
+		ShortestPathTrees(const ShortestPathTrees&) = delete;
+		ShortestPathTrees& operator =(const ShortestPathTrees&) = delete;
+
+		//same contract as Helper::calculate, version is the SubwayGraph version graph was taken from
+		int calculate(const ds::CSRGraph& graph, const bool isWeighted, const uint64_t version, const int origin, const int dst, int*& route, RouteWorkspace& ws)
+		{
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			const Tree* tree = treeOf(graph, isWeighted, version, origin, ws);
+			if (tree == nullptr || tree->dis[dst] == INT_MAX) return 0; //unreachable
+
+			int routeLen = 0;
+			for (int v = dst; v != -1; v = tree->parents[v]) routeLen++;
+			if (route == nullptr)
+				route = (int*)malloc(routeLen * sizeof(int));
+			if (route == nullptr) return 0;
+			int i = routeLen;
+			for (int v = dst; v != -1; v = tree->parents[v]) route[--i] = v;
+			return routeLen;
+		}
+
+		//cost from origin to dst, INT_MAX if dst can't be reached
+		int distance(const ds::CSRGraph& graph, const bool isWeighted, const uint64_t version, const int origin, const int dst, RouteWorkspace& ws)
+		{
+			if (origin < 0 || origin >= graph.size() || dst < 0 || dst >= graph.size()) return INT_MAX; //idx check
+			const Tree* tree = treeOf(graph, isWeighted, version, origin, ws);
+			return tree == nullptr ? INT_MAX : tree->dis[dst];
+		}
+
+		//trees grown since the last clear()
+		inline int growCnt() const {
+			return this->grown;
+		}
+
+		//queries answered by a tree that was already there
+		inline int hitCnt() const {
+			return this->hits;
+		}
+
+		void clear()
+		{
+			for (auto& tree : this->trees)
+			{
+				tree.origin = -1;
+				tree.lastUse = 0;
+				tree.parents.clear();
+				tree.dis.clear();
+			}
+			this->tick = 0;
+			this->grown = 0;
+			this->hits = 0;
+		}
+
+	private:
+		struct Tree
+		{
+			int origin{ -1 };  //-1 while the slot is empty
+			bool isWeighted{ false };
+			uint64_t version{ 0 };
+			uint64_t lastUse{ 0 };
+			ds::Vector<int> parents;
+			ds::Vector<int> dis;  //INT_MAX where unreachable
+		};
+
+		//tree of origin for the current graph, grown into the least recently used slot on a miss
+		const Tree* treeOf(const ds::CSRGraph& graph, const bool isWeighted, const uint64_t version, const int origin, RouteWorkspace& ws)
+		{
+			Tree* victim = &this->trees[0];
+			for (auto& tree : this->trees)
+			{
+				if (tree.origin == origin && tree.isWeighted == isWeighted && tree.version == version && tree.dis.size() == graph.size())
+				{
+					tree.lastUse = ++this->tick;
+					this->hits++;
+					return &tree;
+				}
+				if (tree.lastUse < victim->lastUse) victim = &tree;
+			}
+			if (!grow(graph, isWeighted, origin, ws, *victim))
+			{
+				victim->origin = -1;
+				return nullptr;
+			}
+			victim->origin = origin;
+			victim->isWeighted = isWeighted;
+			victim->version = version;
+			victim->lastUse = ++this->tick;
+			this->grown++;
+			return victim;
+		}
+
+		//one to all search from origin without early stop
+		static bool grow(const ds::CSRGraph& graph, const bool isWeighted, const int origin, RouteWorkspace& ws, Tree& tree)
+		{
+			const int size = graph.size();
+			if (!Search::run(graph, isWeighted, origin, -1, ws) || ws.isInterrupted()) return false;  //a partial tree would serve wrong routes
+			tree.parents.resize(size);
+			tree.dis.resize(size);
+			for (int v = 0; v < size; v++)
+			{
+				tree.parents[v] = ws.parentOf(v);
+				tree.dis[v] = ws.dis(v);
+			}
+			return true;
+		}
+
+	private:
+		Tree trees[SHORTEST_PATH_TREE_CNT];
+		uint64_t tick{ 0 };
+		int grown{ 0 };
+		int hits{ 0 };
+	};
+}
@@ -4,6 +4,9 @@
 #include <assert.h>
 #include "Vector.hpp"
 #include "HashMap.hpp"
+#include "LineSet.hpp"
+#include "CSRGraph.hpp"
+#include "Line.hpp"
 
 namespace ds
 {
@@ -12,14 +15,14 @@ namespace ds
 		Arc(int adjVex, int cost, Arc* next) :adjVex(adjVex), cost(cost), next(next) {};
 		int adjVex;
 		int cost;
-		ds::Vector<int> lineNum;
+		ds::LineSet lineNum;  //lines running on the arc
 		Arc* next{ nullptr };
 	};
 
 	struct Vertex
 	{
 		Vertex(std::string name, ds::Vector<int> lineNum, double x, double y, Vector<int> adjVexes, Vector<int> costs) : name(name), coord_x(x), coord_y(y) {
-			this->lineNum = lineNum;
+			for (auto line : lineNum) this->lineNum.insert(line);  //SubwayGraph::insert checked the range
 			Arc* pArc = nullptr;
 			for (uint32_t i = 0; i < adjVexes.size(); i++) pArc = new Arc(adjVexes[i], costs[i], pArc);
 			this->first = pArc;
@@ -49,12 +52,19 @@ namespace ds
 		}
 
 		std::string name{ "" };
-		ds::Vector<int> lineNum;
+		ds::LineSet lineNum;
 		double coord_x{ 0.f };
 		double coord_y{ 0.f };
 		Arc* first{ nullptr };
 	};
 
+	//a line as the registry of SubwayGraph knows it
+	struct LineInfo
+	{
+		std::string name{ "" };  //empty unless one was given
+		ds::Vector<int> stations;  //in the order they joined the line
+	};
+
 	class SubwayGraph
 	{
 	public:
@@ -65,21 +75,16 @@ namespace ds
 			if (indexOf(name) != -1) return false; //duplication check
 			for (auto elem : adjVexes)
 				if (elem >= vertexes.size()) return false;  //invalid idx check
+			for (auto line : lineNum)
+				if (!ds::isRideLine(line)) return false;  //out of range or reserved
 			vertexes.push_back(Vertex(name, lineNum, longitude, latitude, adjVexes, costs));
-			auto vex = vertexes.back();
+			const auto& vex = vertexes.back();
+			for (auto line : vex.lineNum) joinLine(line, vertexes.size() - 1);
 			for (auto arc = vex.first; arc != nullptr; arc = arc->next)
-			{
-				auto vex2 = vertexes[arc->adjVex];
-				for (int i = 0; i < vex.lineNum.size(); i++)
-				{
-					for (int j = 0; j < vex2.lineNum.size(); j++)
-					{
-						if (vex.lineNum[i] == vex2.lineNum[j]) arc->lineNum.push_back(vex.lineNum[i]);
-					}
-				}
-			}
+				arc->lineNum = vex.lineNum & vertexes[arc->adjVex].lineNum;
 
 			idxMap.insert(name, vertexes.size() - 1);
+			version++;
 			return true;
 		};
 
@@ -89,6 +94,8 @@ namespace ds
 			if (idx == -1) return false;
 			vertexes[idx].destroy();
 			vertexes.erase(&vertexes[idx]);
+			leaveLines(idx);
+			version++;
 			return true;
 		}
 
@@ -111,6 +118,8 @@ namespace ds
 		const bool updateArcCost(int i1, int i2, int newCost)
 		{
 			if (i1 == -1 || i2 == -1) return false;
+			const bool isFrozenCurrent = this->frozenVersion == this->version;
+			const bool isNetworkCurrent = this->networkVersion == this->version;
 			for (auto arc = vertexes[i1].first; arc != nullptr; arc = arc->next) {
 				if (arc->adjVex == i2) arc->cost = newCost;
 			}
@@ -119,6 +128,9 @@ namespace ds
 				if (arc->adjVex == i1) arc->cost = newCost;
 			}
 
+			version++;
+			if (isFrozenCurrent) patchFrozenCost(i1, i2, newCost);  //same topology, no need to compile it again
+			if (isNetworkCurrent) this->networkVersion = this->version;  //stop sequences don't depend on costs
 			return true;
 		}
 
@@ -129,7 +141,7 @@ namespace ds
 			for (auto arc = vertexes[i1].first; arc != nullptr; arc = arc->next) {
 				if (arc->adjVex == i2)
 				{
-					arc->lineNum.find_erase(lineNum);
+					arc->lineNum.erase(lineNum);
 					if (arc->lineNum.empty()) {
 						if (lastArc == nullptr) {
 							vertexes[i1].first = arc->next;
@@ -150,7 +162,7 @@ namespace ds
 			for (auto arc = vertexes[i2].first; arc != nullptr; arc = arc->next) {
 				if (arc->adjVex == i1)
 				{
-					arc->lineNum.find_erase(lineNum);
+					arc->lineNum.erase(lineNum);
 					if (arc->lineNum.empty()) {
 						if (lastArc == nullptr) {
 							vertexes[i2].first = arc->next;
@@ -167,25 +179,30 @@ namespace ds
 				lastArc = arc;
 			}
 
+			version++;
 			return true;
 		}
 
 		const bool connect(int i1, int i2, int lineNum)
 		{
-			if (i1 == -1 || i2 == -1) return false;
+			if (i1 == -1 || i2 == -1 || !ds::isRideLine(lineNum)) return false;
 			for (auto arc = vertexes[i1].first; arc != nullptr; arc = arc->next)
 			{
-				if (arc->adjVex == i2 && arc->lineNum.find(lineNum) != arc->lineNum.end()) return false;
+				if (arc->adjVex == i2 && arc->lineNum.contains(lineNum)) return false;
 			}
 
 			for (auto arc = vertexes[i2].first; arc != nullptr; arc = arc->next)
 			{
-				if (arc->adjVex == i1 && arc->lineNum.find(lineNum) != arc->lineNum.end()) return false;
+				if (arc->adjVex == i1 && arc->lineNum.contains(lineNum)) return false;
 			}
 
 			ds::Arc* arc = vertexes[i1].first;
 			ds::Arc* newArc = new ds::Arc(i2, 1, nullptr);
-			newArc->lineNum.push_back(lineNum);
+			if (!newArc->lineNum.insert(lineNum))
+			{
+				delete newArc;
+				return false;
+			}
 			if (arc == nullptr) {
 				vertexes[i1].first = newArc;
 			}
@@ -194,6 +211,7 @@ namespace ds
 				arc->next = newArc;
 			}
 
+			version++;
 			return true;
 		}
 
@@ -222,23 +240,146 @@ namespace ds
 			return size;
 		}
 
+		//builds a symmetric adjacency snapshot in O(V + E), arc costs are kept as they are
+		//station coordinates and the fastest arc are recorded for goal directed routers, arc lines for transfer aware ones
+		const size_t asCSR(ds::CSRGraph& csr) const {
+			const int size = vertexes.size();
+			csr.clear();
+			if (size <= 0) return 0;
+			csr.vexCnt = size;
+			csr.offsets.resize(size + 1, 0);
+			for (int i = 0; i < size; i++)
+			{
+				for (auto arc = vertexes[i].first; arc != nullptr; arc = arc->next)
+				{
+					if (arc->adjVex < 0 || arc->adjVex >= size) continue;
+					csr.offsets[i + 1]++;
+					csr.offsets[arc->adjVex + 1]++;
+				}
+			}
+			for (int i = 0; i < size; i++) csr.offsets[i + 1] += csr.offsets[i];
+
+			csr.targets.resize(csr.offsets[size]);
+			csr.costs.resize(csr.offsets[size]);
+			csr.lineMasks.resize(csr.offsets[size]);
+			csr.vexLineMasks.resize(size, 0);
+			ds::Vector<int> cursor;
+			cursor.resize(size);
+			for (int i = 0; i < size; i++) cursor[i] = csr.offsets[i];
+			for (int i = 0; i < size; i++)
+			{
+				for (auto arc = vertexes[i].first; arc != nullptr; arc = arc->next)
+				{
+					if (arc->adjVex < 0 || arc->adjVex >= size) continue;
+					uint64_t mask = arc->lineNum.mask;
+					if (mask == 0) mask = 1ull << ds::WALK_LINE;  //arcs without a shared line are walked, so stepping onto them is a transfer
+					csr.vexLineMasks[i] |= mask;
+					csr.vexLineMasks[arc->adjVex] |= mask;
+					csr.lineMasks[cursor[i]] = mask;
+					csr.targets[cursor[i]] = arc->adjVex;
+					csr.costs[cursor[i]++] = arc->cost;
+					csr.lineMasks[cursor[arc->adjVex]] = mask;
+					csr.targets[cursor[arc->adjVex]] = i;
+					csr.costs[cursor[arc->adjVex]++] = arc->cost;
+				}
+			}
+			csr.stateOffsets.resize(size + 1);
+			csr.stateOffsets[0] = 0;
+			for (int i = 0; i < size; i++) csr.stateOffsets[i + 1] = csr.stateOffsets[i] + ds::popcount(csr.vexLineMasks[i]);
+			csr.stateVexes.resize(csr.stateCnt());
+			csr.stateLines.resize(csr.stateCnt());
+			for (int i = 0; i < size; i++)
+			{
+				int state = csr.stateOffsets[i];
+				for (int line = 0; line < ds::MAX_LINES; line++)
+				{
+					if ((csr.vexLineMasks[i] & (1ull << line)) == 0) continue;
+					csr.stateVexes[state] = i;
+					csr.stateLines[state++] = line;
+				}
+			}
+
+			csr.coordX.resize(size);
+			csr.coordY.resize(size);
+			for (int i = 0; i < size; i++)
+			{
+				csr.coordX[i] = vertexes[i].coord_x;
+				csr.coordY[i] = vertexes[i].coord_y;
+			}
+			for (int i = 0; i < size; i++)
+			{
+				for (int e = csr.begin(i); e < csr.end(i); e++)
+				{
+					const double dx = csr.coordX[i] - csr.coordX[csr.targets[e]];
+					const double dy = csr.coordY[i] - csr.coordY[csr.targets[e]];
+					const double len = sqrt(dx * dx + dy * dy);
+					if (len > csr.maxArcLength) csr.maxArcLength = len;
+					if (csr.costs[e] > csr.maxCost) csr.maxCost = csr.costs[e];
+					if (csr.costs[e] > 0 && len / csr.costs[e] > csr.maxSpeed) csr.maxSpeed = len / csr.costs[e];
+				}
+			}
+
+			return size;
+		}
+
+		//immutable CSR snapshot the routers run on, compiled on the first call after the graph changed
+		//cost updates patch a current snapshot in place, every other change leaves it to be compiled again
+		const ds::CSRGraph& freeze() {
+			if (this->frozenVersion != this->version)
+			{
+				asCSR(this->frozen);
+				this->frozenVersion = this->version;
+			}
+			return this->frozen;
+		}
+
+		//stop sequences and branches of every line, ordered along the arcs they run on, built on the first call after the graph changed
+		const ds::LineNetwork& getLineNetwork() {
+			if (this->networkVersion != this->version)
+			{
+				this->network.build(freeze(), this->registeredLines, [this](const int line) -> const ds::Vector<int>& { return this->lines[line].stations; });
+				this->networkVersion = this->version;
+			}
+			return this->network;
+		}
+
 		int size() const {
 			return this->vertexes.size();
 		}
 
+		//bumped by every change to stations, arcs, costs or lines, so anything derived from the graph can tell it is stale
+		uint64_t getVersion() const {
+			return this->version;
+		}
+
+		//lines with at least one station, the registry is kept up to date by every change so this is O(1)
 		int getTotalLines() const {
-			ds::Vector<int> vec;
-			for (int i = 0; i < vertexes.size(); i++) {
-				for(int j = 0; j < vertexes[i].lineNum.size(); j++)
-				if (vec.find(vertexes[i].lineNum[j]) == vec.end()) vec.push_back(vertexes[i].lineNum[j]);
-			}
-			return vec.size();
+			return this->registeredLines.size();
+		}
+
+		const ds::LineSet& getLines() const {
+			return this->registeredLines;
+		}
+
+		//registry entry of line, empty if no station is on it
+		const LineInfo& lineAt(const int line) const {
+			static const LineInfo none;
+			return this->registeredLines.contains(line) ? this->lines[line] : none;
+		}
+
+		bool setLineName(const int line, std::string name) {
+			if (!this->registeredLines.contains(line)) return false;
+			this->lines[line].name = name;
+			return true;
 		}
 
 		bool addLine(std::string name, int lineNum) {
 			int idx = indexOf(name);
-			if (idx == -1) return false;
-			vertexes[idx].lineNum.push_back(lineNum);
+			if (idx == -1 || !ds::isRideLine(lineNum)) return false;
+			if (vertexes[idx].lineNum.contains(lineNum)) return true;  //already on it
+			if (!vertexes[idx].lineNum.insert(lineNum)) return false;
+			joinLine(lineNum, idx);
+			version++;
 			return true;
 		}
 
@@ -258,9 +399,53 @@ namespace ds
 		}
 #endif
 
+	private:
+		//new cost of every snapshot arc between i1 and i2, maxima only grow so bucket sizes and A* bounds stay valid
+		void patchFrozenCost(const int i1, const int i2, const int newCost) {
+			for (int pass = 0; pass < 2; pass++)
+			{
+				const int from = pass == 0 ? i1 : i2;
+				const int to = pass == 0 ? i2 : i1;
+				for (int e = this->frozen.begin(from); e < this->frozen.end(from); e++)
+					if (this->frozen.targets[e] == to) this->frozen.costs[e] = newCost;
+			}
+			if (newCost > this->frozen.maxCost) this->frozen.maxCost = newCost;
+			const double dx = this->frozen.coordX[i1] - this->frozen.coordX[i2];
+			const double dy = this->frozen.coordY[i1] - this->frozen.coordY[i2];
+			const double len = sqrt(dx * dx + dy * dy);
+			if (newCost > 0 && len / newCost > this->frozen.maxSpeed) this->frozen.maxSpeed = len / newCost;
+			this->frozenVersion = this->version;
+		}
+
+		void joinLine(const int line, const int idx) {
+			this->lines[line].stations.push_back(idx);
+			this->registeredLines.insert(line);
+		}
+
+		//drops station idx from its lines and shifts the stations behind it down, as erasing it from vertexes did
+		void leaveLines(const int idx) {
+			for (auto line : this->registeredLines)
+			{
+				auto& stations = this->lines[line].stations;
+				stations.find_erase(idx);
+				for (auto& station : stations)
+					if (station > idx) station--;
+				if (!stations.empty()) continue;
+				this->lines[line].name.clear();
+				this->registeredLines.erase(line);
+			}
+		}
+
 	private:
 		ds::Vector<Vertex> vertexes;
 		ds::HashMap<std::string, int> idxMap;
+		uint64_t version{ 0 };
+		ds::CSRGraph frozen;
+		uint64_t frozenVersion{ UINT64_MAX };  //version frozen was compiled at
+		LineInfo lines[ds::MAX_LINES];  //indexed by line number
+		ds::LineSet registeredLines;
+		ds::LineNetwork network;
+		uint64_t networkVersion{ UINT64_MAX };  //version network was built at
 	};
 }
 
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include "Vector.hpp"
+
+namespace ds
+{
+    //work stealing thread pool for data parallel loops
+    //every worker owns a deque of index ranges: it splits its own ranges from the back and idle workers steal from the front,
+    //so big ranges are handed out early and load balances itself without a central queue
+    class ThreadPool {
+    public:
+        explicit ThreadPool(int threadCnt = 0)
+        {
+            if (threadCnt <= 0) threadCnt = std::thread::hardware_concurrency();
+            if (threadCnt <= 0) threadCnt = 1;
+            this->queueCnt = threadCnt;
+            this->queues = new Queue[threadCnt];
+            for (int w = 0; w < threadCnt; w++) this->workers.push_back(new std::thread(&ThreadPool::run, this, w));
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->wakeMutex);
+                this->isStopping = true;
+            }
+            this->wakeCv.notify_all();
+            for (auto worker : this->workers)
+            {
+                worker->join();
+                delete worker;
+            }
+            delete[] this->queues;
+        }
+
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const
+        {
+            return this->queueCnt;
+        }
+
+        //calls task(i, worker) for every i in [0, count) and blocks until all calls returned
+        //worker is in [0, size()), and no two calls with the same worker run at once, so it can index per worker state
+        //ranges are split down to grain indexes, 0 picks a grain giving every worker a few dozen ranges
+        void parallelFor(const int count, const std::function<void(int, int)>& task, int grain = 0)
+        {
+            if (count <= 0) return;
+            if (grain <= 0) grain = count / (this->queueCnt * 32);
+            if (grain <= 0) grain = 1;
+            Job job{ &task, grain, { count } };
+            for (int w = 0; w < this->queueCnt; w++)  //seed every worker with an equal share
+            {
+                const int begin = (int)((int64_t)count * w / this->queueCnt);
+                const int end = (int)((int64_t)count * (w + 1) / this->queueCnt);
+                if (begin < end) push(w, { &job, begin, end });
+            }
+            std::unique_lock<std::mutex> lock(this->doneMutex);
+            this->doneCv.wait(lock, [&job]() { return job.remaining == 0; });
+        }
+
+    private:
+        struct Job
+        {
+            const std::function<void(int, int)>* task;
+            int grain;
+            std::atomic<int> remaining;  //indexes not yet run
+        };
+
+        struct Range
+        {
+            Job* job;
+            int begin;
+            int end;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        void push(const int w, const Range& range)
+        {
+            {
+                std::lock_guard<std::mutex> lock(this->queues[w].mutex);
+                this->queues[w].ranges.push_back(range);
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->wakeMutex);  //taken so a worker between its check and its wait can't miss the wake up
+                this->queued++;
+            }
+            this->wakeCv.notify_one();
+        }
+
+        //newest range of the own deque, else the oldest range of another worker
+        bool pop(const int w, Range& range)
+        {
+            for (int k = 0; k < this->queueCnt; k++)
+            {
+                Queue& queue = this->queues[(w + k) % this->queueCnt];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.ranges.empty()) continue;
+                if (k == 0)
+                {
+                    range = queue.ranges.back();
+                    queue.ranges.pop_back();
+                }
+                else
+                {
+                    range = queue.ranges.front();
+                    queue.ranges.pop_front();
+                }
+                this->queued--;
+                return true;
+            }
+            return false;
+        }
+
+        void run(const int w)
+        {
+            while (true) {
+                Range range;
+                if (pop(w, range))
+                {
+                    Job* job = range.job;
+                    while (range.end - range.begin > job->grain)  //keep the front half, leave the back half for thieves
+                    {
+                        const int mid = range.begin + (range.end - range.begin) / 2;
+                        push(w, { job, mid, range.end });
+                        range.end = mid;
+                    }
+                    for (int i = range.begin; i < range.end; i++) (*job->task)(i, w);
+                    if (job->remaining.fetch_sub(range.end - range.begin) == range.end - range.begin)
+                    {
+                        std::lock_guard<std::mutex> lock(this->doneMutex);
+                        this->doneCv.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(this->wakeMutex);
+                this->wakeCv.wait(lock, [this]() { return this->isStopping || this->queued > 0; });
+                if (this->isStopping && this->queued == 0) return;
+            }
+        }
+
+    private:
+        ds::Vector<std::thread*> workers;
+        Queue* queues{ nullptr };
+        int queueCnt{ 0 };
+        std::atomic<int> queued{ 0 };  //ranges sitting in any deque
+        bool isStopping{ false };
+        std::mutex wakeMutex;
+        std::condition_variable wakeCv;
+        std::mutex doneMutex;
+        std::condition_variable doneCv;
+    };
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <iostream>
+#include "MinHeap.hpp"
+#include "Vector.hpp"
+#include "CSRGraph.hpp"
+#include "RouteWorkspace.hpp"
+
+namespace Dijkstra
+{
+	//one ride on a single line, from station from to station to
+	struct Leg
+	{
+		int line;
+		int from;
+		int to;
+		int stops;
+	};
+
+	//routes over (station, line) states, so riding, boarding and transferring are explicit arcs:
+	//riding line l from u to v costs the arc cost, switching lines at a station costs transferPenalty and one transfer
+	//states are ordered by (cost, transfers), so with a zero penalty the cheapest route with the fewest transfers wins
+	class TransferRouter
+	{
+	private:
+		TransferRouter() = delete; //INCONSTRUCTIBLE
+		TransferRouter(TransferRouter&&) = delete;
+		TransferRouter(const TransferRouter&) = delete;
+		TransferRouter& operator =(const TransferRouter&) = delete;
+
+		//(cost, transfers) packed into one heap key, both are non negative so the integer order is the lexicographic one
+		static inline int64_t keyOf(const int cost, const int transfers)
+		{
+			return ((int64_t)cost << 32) | (uint32_t)transfers;
+		}
+
+		static inline void relax(RouteWorkspace& ws, ds::IndexedMinHeap<int64_t>& minHeap, const int state, const int cost, const int transfers, const int parent)
+		{
+			if (state < 0 || ws.isSettled(state)) return;
+			if (cost < ws.dis(state) || (cost == ws.dis(state) && transfers < ws.secondaryOf(state)))
+			{
+				ws.relax(state, cost, transfers, parent);
+				minHeap.insert(state, keyOf(cost, transfers));
+			}
+		}
+
+	public:
+		//returns route length and route like Helper::calculate, legs receives one entry per line ridden
+		//lines set in ignoredLines are never boarded
+		static int calculate(const ds::CSRGraph& graph, const bool isWeighted, const int origin, const int dst, const int transferPenalty,
+			int*& route, ds::Vector<Leg>& legs, RouteWorkspace& ws, const uint64_t ignoredLines = 0)
+		{
+			legs.clear();
+			const int size = graph.size();
+			if (size <= 0) return 0; //size check
+			if (origin < 0 || origin >= size || dst < 0 || dst >= size) return 0; //idx check
+			if (origin == dst)
+			{
+				if (route == nullptr) route = (int*)malloc(sizeof(int));
+				if (route == nullptr) return 0;
+				route[0] = origin;
+				return 1;
+			}
+			if (!ws.reset(graph.stateCnt())) return 0;
+
+			ds::IndexedMinHeap<int64_t>& minHeap = ws.stateHeap();
+			if (!minHeap.reset(graph.stateCnt())) return 0;
+			const uint64_t originLines = graph.vexLineMasks[origin] & ~ignoredLines;
+			for (int line = 0; line < ds::MAX_LINES; line++)  //boarding at origin is free
+			{
+				if ((originLines & (1ull << line)) == 0) continue;
+				const int state = graph.stateOf(origin, line);
+				ws.relax(state, 0, 0, -1);
+				minHeap.insert(state, keyOf(0, 0));
+			}
+
+			int dstState = -1;
+			while (!minHeap.empty() && !ws.isInterrupted()) {
+				const int cur = minHeap.front().idx;
+				minHeap.pop();
+				ws.settle(cur);
+				const int vex = graph.stateVexes[cur];
+				if (vex == dst)
+				{
+					dstState = cur;
+					break;
+				}
+				const int line = graph.stateLines[cur];
+				const int curCost = ws.dis(cur);
+				const int curTransfers = ws.secondaryOf(cur);
+				const uint64_t bit = 1ull << line;
+
+				//ride the current line to a neighbour
+				for (int e = graph.begin(vex); e < graph.end(vex); e++)
+				{
+					if ((graph.lineMasks[e] & bit) == 0) continue;
+					const int cost = isWeighted ? graph.costs[e] : 1;
+					if (cost <= 0) continue;  //not connected
+					const int next = graph.stateOf(graph.targets[e], line);
+					relax(ws, minHeap, next, curCost + cost, curTransfers, cur);
+				}
+
+				//transfer to another line at the same station
+				uint64_t others = graph.vexLineMasks[vex] & ~ignoredLines & ~bit;
+				for (int other = 0; others != 0; other++)
+				{
+					if ((others & (1ull << other)) == 0) continue;
+					others &= ~(1ull << other);
+					const int next = graph.stateOf(vex, other);
+					relax(ws, minHeap, next, curCost + transferPenalty, curTransfers + 1, cur);
+				}
+			}
+			if (dstState == -1 || ws.isInterrupted()) return 0; //unreachable or given up
+
+			//unwind the states, consecutive states on one vertex are a transfer
+			int stateCnt = 0;
+			for (int s = dstState; s != -1; s = ws.parentOf(s)) stateCnt++;
+			ds::Vector<int> states;
+			states.resize(stateCnt);
+			for (int s = dstState, i = stateCnt; s != -1; s = ws.parentOf(s)) states[--i] = s;
+
+			int routeLen = 0;
+			for (int k = 0; k < stateCnt; k++)
+				if (k == 0 || graph.stateVexes[states[k]] != graph.stateVexes[states[k - 1]]) routeLen++;
+			if (route == nullptr)
+				route = (int*)malloc(routeLen * sizeof(int));
+			if (route == nullptr) return 0;
+
+			int i = 0;
+			int lastVex = -1;
+			for (int k = 0; k < stateCnt; k++)
+			{
+				const int vex = graph.stateVexes[states[k]];
+				const int line = graph.stateLines[states[k]];
+				if (vex != lastVex) route[i++] = vex;
+				if (legs.empty() || legs.back().line != line)
+					legs.push_back({ line, vex, vex, 0 });
+				else if (vex != lastVex)
+				{
+					legs.back().to = vex;
+					legs.back().stops++;
+				}
+				lastVex = vex;
+			}
+
+			return routeLen;
+		}
+
+		//minimum transfer line assignment over a fixed route, for routers that only return a station sequence
+		//a dp row over (position, line) only ever holds the minimum leg count or one more, so it is kept as the mask of lines
+		//still reaching the minimum: O(routeLen) mask operations, no recursion and no scratch memory
+		//returns the number of legs, or -1 if two consecutive stations aren't connected
+		static int assignLines(const ds::CSRGraph& graph, const int* route, const int routeLen, ds::Vector<Leg>& legs)
+		{
+			legs.resize(0);
+			if (route == nullptr || routeLen <= 1) return 0;
+			uint64_t runMask = 0;  //lines that can ride the whole current leg
+			int legStart = 0;
+			for (int k = 0; k + 1 < routeLen; k++)
+			{
+				uint64_t arcMask = 0;
+				for (int e = graph.begin(route[k]); e < graph.end(route[k]); e++)
+					if (graph.targets[e] == route[k + 1]) arcMask |= graph.lineMasks[e];
+				if (arcMask == 0) return -1;
+				if (k > 0 && (runMask & arcMask) == 0)  //no line rides on, transfer at route[k]
+				{
+					legs.push_back({ ds::lowestLine(runMask), route[legStart], route[k], k - legStart });
+					legStart = k;
+					runMask = arcMask;
+				}
+				else runMask = k == 0 ? arcMask : (runMask & arcMask);
+			}
+			legs.push_back({ ds::lowestLine(runMask), route[legStart], route[routeLen - 1], routeLen - 1 - legStart });
+			return legs.size();
+		}
+	};
+}